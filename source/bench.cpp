@@ -0,0 +1,276 @@
+/**
+ * @file bench.cpp
+ *
+ * headless benchmark: mills a positions file without displaying anything
+ * and writes a machine readable report of the milling performances
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include <boost/chrono.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/program_options.hpp>
+
+#include "common/constants.hpp"
+#include "common/Trace.hpp"
+#include "configuration/ConfigFileParser.hpp"
+#include "milling/Cutter.hpp"
+#include "milling/IntersectionResult.hpp"
+#include "milling/MillingAlgorithm.hpp"
+#include "milling/Stock.hpp"
+#include "meshing/StubMesher.hpp"
+
+using namespace std;
+
+namespace bpo = boost::program_options;
+
+/**
+ * benchmark parameters
+ */
+struct BenchOptions {
+	std::string configFile;
+	std::string reportFile;
+	std::string traceFile;
+	std::string checkpointFile;
+	std::string resumeFile;
+	float minVoxelSize;
+	unsigned int nThreads;
+	unsigned int batchSize;
+	unsigned int prefetchDepth;
+	unsigned long maxMoves;
+	unsigned int checkpointStep;
+	unsigned int checkpointMoves;
+	unsigned int checkpointSeconds;
+	unsigned int checkpointRetention;
+	unsigned int compactMoves;
+	int depthSwitch;
+	bool sweep;
+};
+
+/**
+ *
+ * @return peak resident set size of the process in KiB (0 if unknown)
+ */
+static unsigned long getPeakRSS() {
+#ifdef _WIN32
+	return 0;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+
+#ifdef __APPLE__
+	return usage.ru_maxrss / 1024; // bytes
+#else
+	return usage.ru_maxrss;
+#endif
+#endif
+}
+
+/**
+ *
+ * @param sorted sorted values
+ * @param p percentile, in [0, 100]
+ * @return the nearest-rank percentile of the values
+ */
+static double percentile(const std::vector< double > &sorted, double p) {
+	if (sorted.empty())
+		return 0;
+
+	std::size_t rank = std::ceil(p / 100.0 * sorted.size());
+	return sorted[std::max< std::size_t >(rank, 1) - 1];
+}
+
+/**
+ *
+ * @param str
+ * @return given string as a JSON literal
+ */
+static std::string jsonString(const std::string &str) {
+	std::string quoted = "\"";
+	for (std::string::const_iterator it = str.begin(); it != str.end(); ++it) {
+		if (*it == '"' || *it == '\\')
+			quoted += '\\';
+		quoted += *it;
+	}
+
+	return quoted + "\"";
+}
+
+/**
+ * main
+ *
+ * @param argc : number of command-line parameters
+ * @param argv : the command-line parameters
+ * @return exit status of the program
+ */
+int main(int argc, char **argv) {
+
+	BenchOptions opts;
+	bpo::options_description description("Available options");
+	description.add_options()
+			("help,h", "produces this help message")
+			("config,c", bpo::value< std::string >(&opts.configFile)->default_value(CMDLN_CONFFILE_NAME), "position of the configuration file")
+			("vsize,s", bpo::value< float >(&opts.minVoxelSize)->default_value(CMDLN_MIN_VOXEL_SIZE), "minimum voxel size: all voxel dimensions should be equal or less then specified value")
+			("threads,j", bpo::value< unsigned int >(&opts.nThreads)->default_value(CMDLN_THREADS), "number of threads used to mill each move")
+			("batch,b", bpo::value< unsigned int >(&opts.batchSize)->default_value(CMDLN_BATCH_SIZE), "number of moves milled in a single stock traversal")
+			("prefetch,q", bpo::value< unsigned int >(&opts.prefetchDepth)->default_value(CMDLN_PREFETCH_DEPTH), "number of moves parsed ahead of milling by a dedicated thread (0 parses them in the milling thread)")
+			("compact,g", bpo::value< unsigned int >(&opts.compactMoves)->default_value(0), "number of moves between compactions of the stock, merging untouched sibling voxels (0 never compacts it). The waste is approximated: milling a merged voxel may count slightly less waste than milling its siblings would")
+			("sat-depth,d", bpo::value< int >(&opts.depthSwitch)->default_value(CMDLN_DEPTH_SWITCH), "first depth whose voxels are tested against the cutter bounding box instead of the separating axis test (negative chooses it profiling the first moves that mill some material: depths discard different voxels, so milling results may slightly differ from a run to another)")
+			("sweep,w", "mills all the material met by the cutter moving between consecutive moves, not only at moves positions")
+			("moves,n", bpo::value< unsigned long >(&opts.maxMoves)->default_value(0), "number of moves to mill (0 mills all of them)")
+			("checkpoint,x", bpo::value< std::string >(&opts.checkpointFile), "writes stock and milling progress to the given checkpoint file, as set by --checkpoint-at, --checkpoint-every and --checkpoint-seconds")
+			("checkpoint-at,a", bpo::value< unsigned int >(&opts.checkpointStep)->default_value(0), "number of moves to mill before writing a checkpoint")
+			("checkpoint-every,y", bpo::value< unsigned int >(&opts.checkpointMoves)->default_value(0), "number of moves between periodic checkpoints")
+			("checkpoint-seconds,i", bpo::value< unsigned int >(&opts.checkpointSeconds)->default_value(0), "number of seconds between periodic checkpoints")
+			("checkpoint-keep,l", bpo::value< unsigned int >(&opts.checkpointRetention)->default_value(CMDLN_CHECKPOINT_RETENTION), "number of checkpoints kept: the older ones are numbered from 1")
+			("resume,u", bpo::value< std::string >(&opts.resumeFile), "resumes milling from the given checkpoint file, written with the same positions file and voxel size")
+			("trace,r", bpo::value< std::string >(&opts.traceFile), "writes a Chrome trace (chrome://tracing) of milling phases to the given file")
+			("report,o", bpo::value< std::string >(&opts.reportFile)->default_value("-"), "file the JSON report is written to ('-' for the standard output)")
+	;
+	bpo::positional_options_description positionals;
+	positionals.add("config", -1);
+
+	bpo::variables_map vm;
+	bpo::store(bpo::command_line_parser(argc, argv).
+			options(description).
+			positional(positionals).run(),
+			vm);
+	bpo::notify(vm);
+
+	if (vm.count("help")) {
+		cout << "Usage: " << argv[0] << " [options] pointsFile" << endl;
+		cout << description << endl;
+		return 0;
+	}
+	opts.sweep = vm.count("sweep");
+
+	if (!opts.traceFile.empty()) {
+		Trace::enable(opts.traceFile);
+		Trace::nameThread("miller");
+	}
+
+	// **** SETUP (same as the simulator) **** //
+	ConfigFileParser cfp(opts.configFile);
+
+	double maxDim = cfp.getStockDescription()->getGeometry()->asEigen().maxCoeff();
+	unsigned int max_depth = log(maxDim / opts.minVoxelSize) / log(2.0) + 1;
+
+	Stock::Ptr stock = boost::make_shared< Stock >(*cfp.getStockDescription(), max_depth,
+			boost::make_shared< StubMesher< StoredData > >(), opts.nThreads, opts.depthSwitch);
+	Cutter::Ptr cutter = Cutter::buildCutter(*cfp.getCutterDescription());
+
+	CheckpointConf checkpointConf(opts.checkpointFile, opts.checkpointStep,
+			opts.checkpointMoves, opts.checkpointSeconds, opts.checkpointRetention);
+	MillingAlgorithmConf millingConf(stock, cutter, cfp.CNCMoveBegin(), cfp.CNCMoveEnd(),
+			ALG_WATER_REMOTION_RATE, ALG_WATER_THRESHOLD, opts.batchSize,
+			opts.sweep, opts.prefetchDepth,
+			checkpointConf, opts.resumeFile, opts.compactMoves);
+	
+	// a checkpoint, if any, is loaded here
+	boost::chrono::steady_clock::time_point resumeStart = boost::chrono::steady_clock::now();
+	MillingAlgorithm algorithm(millingConf);
+	boost::chrono::duration< double > resumeTime = boost::chrono::steady_clock::now() - resumeStart;
+	unsigned int resumedMoves = algorithm.getStepNumber();
+
+	// **** MILL **** //
+	IntersectionResult total;
+	unsigned long moves = 0;
+	/* wall time of each pass, that is, of the steps milling a batch:
+	 * IntersectionResult::elapsedTime is split evenly among the moves of
+	 * a batch, and it is thread time with a single thread
+	 */
+	std::vector< double > latencies; // us
+
+	boost::chrono::steady_clock::time_point start = boost::chrono::steady_clock::now();
+	while (algorithm.hasNextStep() && (opts.maxMoves == 0 || moves < opts.maxMoves)) {
+		bool newPass = algorithm.getPendingSteps() == 0;
+		boost::chrono::steady_clock::time_point stepStart = boost::chrono::steady_clock::now();
+		MillingAlgorithm::StepInfo info = algorithm.step();
+		boost::chrono::duration< double, boost::micro > stepTime = boost::chrono::steady_clock::now() - stepStart;
+
+		if (newPass) {
+			latencies.push_back(stepTime.count());
+		}
+		total += info.first.intersection;
+		moves++;
+	}
+	boost::chrono::duration< double > wallTime = boost::chrono::steady_clock::now() - start;
+	Trace::write();
+
+	// **** REPORT **** //
+	double meanLatency = 0;
+	for (std::size_t i = 0; i < latencies.size(); ++i) {
+		meanLatency += latencies[i];
+	}
+	if (!latencies.empty()) {
+		meanLatency /= latencies.size();
+	}
+	std::sort(latencies.begin(), latencies.end());
+	Stock::NodesCount nodes = stock->countNodes();
+
+	std::ofstream reportFile;
+	if (opts.reportFile != "-") {
+		reportFile.open(opts.reportFile.c_str());
+		if (!reportFile.is_open()) {
+			cerr << "Can't write report file " << opts.reportFile << endl;
+			return 1;
+		}
+	}
+	std::ostream &os = reportFile.is_open() ? reportFile : cout;
+
+	os.precision(12);
+	os << "{" << endl
+			<< "\t\"config\": " << jsonString(opts.configFile) << "," << endl
+			<< "\t\"vsize\": " << opts.minVoxelSize << "," << endl
+			<< "\t\"threads\": " << opts.nThreads << "," << endl
+			<< "\t\"batch\": " << opts.batchSize << "," << endl
+			<< "\t\"sweep\": " << (opts.sweep ? "true" : "false") << "," << endl
+			<< "\t\"prefetch\": " << opts.prefetchDepth << "," << endl
+			<< "\t\"compact\": " << opts.compactMoves << "," << endl
+			<< "\t\"sat_depth\": " << stock->getDepthSwitch() << "," << endl
+			<< "\t\"resumed_moves\": " << resumedMoves << "," << endl
+			<< "\t\"resume_s\": " << resumeTime.count() << "," << endl
+			<< "\t\"moves\": " << moves << "," << endl
+			<< "\t\"passes\": " << latencies.size() << "," << endl
+			<< "\t\"wall_time_s\": " << wallTime.count() << "," << endl
+			<< "\t\"moves_per_s\": " << ((wallTime.count() > 0) ? moves / wallTime.count() : 0) << "," << endl
+			<< "\t\"pass_latency_us\": {"
+				<< "\"clock\": \"steady_clock\""
+				<< ", \"mean\": " << meanLatency
+				<< ", \"p50\": " << percentile(latencies, 50)
+				<< ", \"p90\": " << percentile(latencies, 90)
+				<< ", \"p99\": " << percentile(latencies, 99)
+				<< ", \"max\": " << (latencies.empty() ? 0 : latencies.back())
+				<< "}," << endl
+			<< "\t\"waste\": " << total.waste << "," << endl
+			<< "\t\"leaves\": {"
+				<< "\"analyzed\": " << total.analyzed_leaves
+				<< ", \"purged\": " << total.purged_leaves
+				<< ", \"pushed\": " << total.pushed_leaves
+				<< ", \"updated\": " << total.updated_data_leaves
+				<< "}," << endl
+			<< "\t\"descent_cache\": {"
+				<< "\"hits\": " << total.descent_cache_hits
+				<< ", \"misses\": " << total.descent_cache_misses
+				<< "}," << endl
+			<< "\t\"nodes\": {"
+				<< "\"branches\": " << nodes.branches
+				<< ", \"leaves\": " << nodes.leaves
+				<< ", \"merged\": " << algorithm.getMergedBranches()
+				<< "}," << endl
+			<< "\t\"prefetch_stalls\": " << algorithm.getPrefetchStalls() << "," << endl
+			<< "\t\"peak_rss_kb\": " << getPeakRSS() << endl
+			<< "}" << endl;
+
+	return 0;
+}
@@ -8,13 +8,80 @@
 #ifndef ATOMICNUMBER_HPP_
 #define ATOMICNUMBER_HPP_
 
+#include <boost/noncopyable.hpp>
+
+#if !defined(__GNUC__) || !defined(__ATOMIC_SEQ_CST)
 #include <boost/thread.hpp>
+#endif
+
+/**
+ * @class AtomicOrder
+ *
+ * memory orderings available for AtomicNumber operations: loads use the
+ * acquire part of the chosen order and stores its release part
+ */
+class AtomicOrder {
+	
+public:
+	enum Type {
+		/** only atomicity is guaranteed (counters, statistics) */
+		RELAXED,
+		
+		/** loads acquire, stores and read-modify-writes release */
+		ACQ_REL,
+		
+		/** single total order of all the operations (default) */
+		SEQ_CST
+	};
+};
 
-template < typename T >
+template < typename T, AtomicOrder::Type ORDER = AtomicOrder::SEQ_CST >
 /**
  * @class AtomicNumber
+ *
+ * Number that can be read and modified concurrently by more threads. With
+ * GCC compatible compilers operations are lock-free, otherwise they are
+ * guarded by a mutex (ORDER is then ignored and all operations are
+ * sequentially consistent).
  */
-class AtomicNumber {
+class AtomicNumber : boost::noncopyable {
+	
+#if defined(__GNUC__) && defined(__ATOMIC_SEQ_CST)
+	
+private:
+	static const int LOAD_ORDER = (ORDER == AtomicOrder::RELAXED) ? __ATOMIC_RELAXED :
+			(ORDER == AtomicOrder::ACQ_REL) ? __ATOMIC_ACQUIRE : __ATOMIC_SEQ_CST;
+	
+	static const int STORE_ORDER = (ORDER == AtomicOrder::RELAXED) ? __ATOMIC_RELAXED :
+			(ORDER == AtomicOrder::ACQ_REL) ? __ATOMIC_RELEASE : __ATOMIC_SEQ_CST;
+	
+	static const int RMW_ORDER = (ORDER == AtomicOrder::RELAXED) ? __ATOMIC_RELAXED :
+			(ORDER == AtomicOrder::ACQ_REL) ? __ATOMIC_ACQ_REL : __ATOMIC_SEQ_CST;
+	
+	T number;
+	
+public:
+	AtomicNumber() : number(0) { }
+	AtomicNumber(T val) : number(val) { }
+	virtual ~AtomicNumber() { }
+	
+	T get() const {
+		return __atomic_load_n(&number, LOAD_ORDER);
+	}
+	
+	T set(const T n)  {
+		return __atomic_exchange_n(&number, n, RMW_ORDER);
+	}
+
+	T addAndGet(const T n) {
+		return __atomic_add_fetch(&number, n, RMW_ORDER);
+	}
+	
+	T getAndAdd(const T n) {
+		return __atomic_fetch_add(&number, n, RMW_ORDER);
+	}
+	
+#else
 	
 private:
 	/* there's no need to use a shared lock because it is more expensive than
@@ -64,6 +131,8 @@ public:
 		return copy;
 	}
 	
+#endif
+	
 	T incAndGet() { return addAndGet(1); }
 	T getAndInc() { return getAndAdd(1); }
 	T decAndGet() { return addAndGet(-1); }
@@ -0,0 +1,89 @@
+/**
+ * SimdDouble.hpp
+ *
+ *  Created on: 17/ott/2026
+ *      Author: socket
+ */
+
+#ifndef SIMDDOUBLE_HPP_
+#define SIMDDOUBLE_HPP_
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#else
+#include <cmath>
+#endif
+
+/**
+ * @class SimdDouble
+ *
+ * Thin wrapper around the widest vector of doubles available at compile
+ * time (AVX, SSE2 or a plain double), so that kernels can be written once.
+ * Comparisons return a bit mask with one bit for each lane, the first lane
+ * being the less significant bit.
+ */
+class SimdDouble {
+
+public:
+
+#if defined(__AVX__)
+
+	typedef __m256d Vector;
+	static const int WIDTH = 4;
+
+	static inline Vector load(const double *p) { return _mm256_loadu_pd(p); }
+	static inline void store(double *p, Vector v) { _mm256_storeu_pd(p, v); }
+	static inline Vector set(double d) { return _mm256_set1_pd(d); }
+
+	static inline Vector add(Vector a, Vector b) { return _mm256_add_pd(a, b); }
+	static inline Vector sub(Vector a, Vector b) { return _mm256_sub_pd(a, b); }
+	static inline Vector mul(Vector a, Vector b) { return _mm256_mul_pd(a, b); }
+	static inline Vector abs(Vector a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+
+	static inline int equal(Vector a, Vector b) { return _mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_EQ_OQ)); }
+	static inline int less(Vector a, Vector b) { return _mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_LT_OQ)); }
+	static inline int lessEqual(Vector a, Vector b) { return _mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_LE_OQ)); }
+
+#elif defined(__SSE2__)
+
+	typedef __m128d Vector;
+	static const int WIDTH = 2;
+
+	static inline Vector load(const double *p) { return _mm_loadu_pd(p); }
+	static inline void store(double *p, Vector v) { _mm_storeu_pd(p, v); }
+	static inline Vector set(double d) { return _mm_set1_pd(d); }
+
+	static inline Vector add(Vector a, Vector b) { return _mm_add_pd(a, b); }
+	static inline Vector sub(Vector a, Vector b) { return _mm_sub_pd(a, b); }
+	static inline Vector mul(Vector a, Vector b) { return _mm_mul_pd(a, b); }
+	static inline Vector abs(Vector a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+
+	static inline int equal(Vector a, Vector b) { return _mm_movemask_pd(_mm_cmpeq_pd(a, b)); }
+	static inline int less(Vector a, Vector b) { return _mm_movemask_pd(_mm_cmplt_pd(a, b)); }
+	static inline int lessEqual(Vector a, Vector b) { return _mm_movemask_pd(_mm_cmple_pd(a, b)); }
+
+#else
+
+	typedef double Vector;
+	static const int WIDTH = 1;
+
+	static inline Vector load(const double *p) { return *p; }
+	static inline void store(double *p, Vector v) { *p = v; }
+	static inline Vector set(double d) { return d; }
+
+	static inline Vector add(Vector a, Vector b) { return a + b; }
+	static inline Vector sub(Vector a, Vector b) { return a - b; }
+	static inline Vector mul(Vector a, Vector b) { return a * b; }
+	static inline Vector abs(Vector a) { return std::fabs(a); }
+
+	static inline int equal(Vector a, Vector b) { return a == b; }
+	static inline int less(Vector a, Vector b) { return a < b; }
+	static inline int lessEqual(Vector a, Vector b) { return a <= b; }
+
+#endif
+
+};
+
+#endif /* SIMDDOUBLE_HPP_ */
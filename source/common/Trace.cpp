@@ -0,0 +1,130 @@
+/*
+ * Trace.cpp
+ *
+ *  Created on: 17/ott/2026
+ *      Author: socket
+ */
+
+#include "Trace.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+bool Trace::enabled = false;
+std::string Trace::traceFile;
+Trace::TimePoint Trace::origin;
+
+boost::mutex Trace::buffersMutex;
+boost::ptr_vector< Trace::ThreadBuffer > Trace::buffers;
+// buffers are owned by #buffers, they must survive their threads
+boost::thread_specific_ptr< Trace::ThreadBuffer > Trace::threadBuffer(&Trace::noCleanup);
+
+AtomicNumber< unsigned long, AtomicOrder::RELAXED > Trace::counters[N_COUNTERS];
+
+void Trace::enable(const std::string &file) {
+	traceFile = file;
+	origin = boost::chrono::steady_clock::now();
+	enabled = true;
+}
+
+void Trace::sampleCounters() {
+	if (!enabled)
+		return;
+
+	Sample sample;
+	sample.time = toTraceTime(boost::chrono::steady_clock::now());
+	for (int c = 0; c < N_COUNTERS; ++c) {
+		sample.values[c] = counters[c].get();
+	}
+
+	getBuffer().samples.push_back(sample);
+}
+
+void Trace::nameThread(const std::string &name) {
+	if (enabled)
+		getBuffer().name = name;
+}
+
+void Trace::record(const char *name, const char *category,
+		const TimePoint &start, const TimePoint &end) {
+
+	Event event;
+	event.name = name;
+	event.category = category;
+	event.start = toTraceTime(start);
+	event.duration = boost::chrono::duration_cast< boost::chrono::nanoseconds >(end - start).count();
+
+	getBuffer().events.push_back(event);
+}
+
+Trace::ThreadBuffer &Trace::getBuffer() {
+	ThreadBuffer *buffer = threadBuffer.get();
+
+	if (buffer == NULL) {
+		buffer = new ThreadBuffer();
+
+		boost::lock_guard< boost::mutex > l(buffersMutex);
+		buffer->tid = buffers.size() + 1;
+		buffers.push_back(buffer);
+		threadBuffer.reset(buffer);
+	}
+
+	return *buffer;
+}
+
+boost::int64_t Trace::toTraceTime(const TimePoint &time) {
+	return boost::chrono::duration_cast< boost::chrono::nanoseconds >(time - origin).count();
+}
+
+void Trace::write() {
+	if (!enabled)
+		return;
+
+	std::ofstream ofs(traceFile.c_str());
+	if (!ofs.is_open())
+		throw std::runtime_error("can't write trace file " + traceFile);
+
+	static const char *COUNTER_NAMES[N_COUNTERS] = { "sat", "aabb" };
+
+	boost::lock_guard< boost::mutex > l(buffersMutex);
+
+	ofs << "{\"traceEvents\":[" << std::endl;
+	const char *separator = "";
+	// trace times are in microseconds
+	ofs.setf(std::ios::fixed);
+	ofs.precision(3);
+
+	boost::ptr_vector< ThreadBuffer >::const_iterator it = buffers.begin();
+	for (; it != buffers.end(); ++it) {
+		if (!it->name.empty()) {
+			ofs << separator << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << it->tid
+					<< ",\"args\":{\"name\":\"" << it->name << "\"}}";
+			separator = ",\n";
+		}
+
+		std::vector< Event >::const_iterator evIt = it->events.begin();
+		for (; evIt != it->events.end(); ++evIt) {
+			ofs << separator << "{\"name\":\"" << evIt->name << "\",\"cat\":\"" << evIt->category
+					<< "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << it->tid
+					<< ",\"ts\":" << evIt->start / 1000.0 << ",\"dur\":" << evIt->duration / 1000.0 << "}";
+			separator = ",\n";
+		}
+
+		std::vector< Sample >::const_iterator smIt = it->samples.begin();
+		for (; smIt != it->samples.end(); ++smIt) {
+			ofs << separator << "{\"name\":\"box tests\",\"ph\":\"C\",\"pid\":1,\"tid\":" << it->tid
+					<< ",\"ts\":" << smIt->time / 1000.0 << ",\"args\":{";
+			for (int c = 0; c < N_COUNTERS; ++c) {
+				ofs << (c ? "," : "") << "\"" << COUNTER_NAMES[c] << "\":" << smIt->values[c];
+			}
+			ofs << "}}";
+			separator = ",\n";
+		}
+	}
+
+	ofs << std::endl << "]}" << std::endl;
+
+	if (ofs.fail())
+		throw std::runtime_error("error writing trace file " + traceFile);
+}
@@ -0,0 +1,171 @@
+/**
+ * Trace.hpp
+ *
+ *  Created on: 17/ott/2026
+ *      Author: socket
+ */
+
+#ifndef TRACE_HPP_
+#define TRACE_HPP_
+
+#include <string>
+#include <vector>
+
+#include <boost/chrono.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+
+#include "AtomicNumber.hpp"
+
+/**
+ * @class Trace
+ *
+ * Collects the duration of the phases of milling and meshing, and some
+ * counters, and writes them as a Chrome trace (chrome://tracing or
+ * Perfetto). Every thread records its events in its own buffer, so
+ * recording never contends for a lock.
+ *
+ * Tracing is disabled by default: scopes and counters then cost a single
+ * test of a flag. It has to be enabled before starting the threads that
+ * are traced, and written after they have stopped.
+ */
+class Trace {
+
+public:
+	/**
+	 * counters sampled by #sampleCounters
+	 */
+	enum Counter {
+		SAT_TESTS,  //!< separating axis box tests
+		AABB_TESTS, //!< axis aligned box tests
+		N_COUNTERS
+	};
+
+	/**
+	 * @class Scope
+	 *
+	 * records the time elapsed from its construction to its destruction
+	 * as an event of the calling thread
+	 */
+	class Scope : boost::noncopyable {
+
+	private:
+		const char * const NAME;
+		const char * const CATEGORY;
+		const bool ACTIVE;
+		boost::chrono::steady_clock::time_point start;
+
+	public:
+		/**
+		 * constructor
+		 * @param name name of the event: it must be a string literal
+		 * @param category category of the event: it must be a string literal
+		 */
+		Scope(const char *name, const char *category) :
+			NAME(name), CATEGORY(category), ACTIVE(Trace::enabled)
+		{
+			if (ACTIVE)
+				start = boost::chrono::steady_clock::now();
+		}
+
+		~Scope() {
+			if (ACTIVE)
+				Trace::record(NAME, CATEGORY, start, boost::chrono::steady_clock::now());
+		}
+	};
+
+private:
+	typedef boost::chrono::steady_clock::time_point TimePoint;
+
+	struct Event {
+		const char *name;
+		const char *category;
+		boost::int64_t start, duration; // ns from #origin
+	};
+
+	struct Sample {
+		boost::int64_t time; // ns from #origin
+		unsigned long values[N_COUNTERS];
+	};
+
+	struct ThreadBuffer {
+		unsigned int tid;
+		std::string name;
+		std::vector< Event > events;
+		std::vector< Sample > samples;
+	};
+
+	static bool enabled;
+	static std::string traceFile;
+	static TimePoint origin;
+
+	static boost::mutex buffersMutex;
+	/** buffers of all the threads, also of the ones already terminated */
+	static boost::ptr_vector< ThreadBuffer > buffers;
+	static boost::thread_specific_ptr< ThreadBuffer > threadBuffer;
+
+	// only read as a statistic: no ordering with other memory is needed
+	static AtomicNumber< unsigned long, AtomicOrder::RELAXED > counters[N_COUNTERS];
+
+public:
+	/**
+	 * starts tracing
+	 * @param file where the trace will be written by #write
+	 */
+	static void enable(const std::string &file);
+
+	/**
+	 *
+	 * @return True if tracing is enabled
+	 */
+	inline
+	static bool isEnabled() {
+		return enabled;
+	}
+
+	/**
+	 * increments a counter
+	 * @param counter
+	 */
+	inline
+	static void count(Counter counter) {
+		if (enabled)
+			counters[counter].incAndGet();
+	}
+
+	/**
+	 * records the current values of the counters in the trace
+	 */
+	static void sampleCounters();
+
+	/**
+	 * names the calling thread in the trace
+	 * @param name
+	 */
+	static void nameThread(const std::string &name);
+
+	/**
+	 * writes the trace file: traced threads must not record events in the
+	 * meanwhile
+	 * @throw std::runtime_error if the file cannot be written
+	 */
+	static void write();
+
+private:
+	static void record(const char *name, const char *category,
+			const TimePoint &start, const TimePoint &end);
+
+	/**
+	 *
+	 * @return the buffer of the calling thread
+	 */
+	static ThreadBuffer &getBuffer();
+
+	static boost::int64_t toTraceTime(const TimePoint &time);
+
+	static void noCleanup(ThreadBuffer *) { }
+};
+
+#endif /* TRACE_HPP_ */
@@ -9,6 +9,8 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <cstdlib>
+#include <algorithm>
 
 #include <boost/regex.hpp>
 #include <boost/algorithm/string.hpp>
@@ -85,3 +87,103 @@ std::string StringUtils::repeat(const std::string &pattern, unsigned int nTimes)
 	return sstream.str();
 }
 
+bool StringUtils::parseDouble(const char *&it, const char *end, double &value) {
+	
+	/* powers of ten exactly representable as doubles: when both mantissa
+	 * and power are exact, a single multiplication or division gives the
+	 * correctly rounded result, as strtod does
+	 */
+	static const double POW10[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+	static const int MAX_POW10 = 22;
+	static const int MAX_EXACT_DIGITS = 15;
+	
+	const char *p = it;
+	
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+')) {
+		negative = (*p == '-');
+		++p;
+	}
+	
+	unsigned long long mantissa = 0;
+	int significantDigits = 0;
+	int exponent = 0;
+	bool hasDigits = false;
+	
+	// integer part
+	for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+		hasDigits = true;
+		if (mantissa || *p != '0') {
+			// digits beyond the exact ones are only counted (see slow path)
+			if (significantDigits <= MAX_EXACT_DIGITS) {
+				mantissa = mantissa * 10 + (*p - '0');
+			}
+			++significantDigits;
+		}
+	}
+	
+	// fraction part
+	if (p < end && *p == '.') {
+		for (++p; p < end && *p >= '0' && *p <= '9'; ++p) {
+			hasDigits = true;
+			if (mantissa || *p != '0') {
+				if (significantDigits <= MAX_EXACT_DIGITS) {
+					mantissa = mantissa * 10 + (*p - '0');
+				}
+				++significantDigits;
+			}
+			--exponent;
+		}
+	}
+	
+	if (!hasDigits) {
+		return false;
+	}
+	
+	// exponent part
+	if (p < end && (*p == 'e' || *p == 'E')) {
+		const char *e = p + 1;
+		bool negativeExp = false;
+		if (e < end && (*e == '-' || *e == '+')) {
+			negativeExp = (*e == '-');
+			++e;
+		}
+		
+		if (e < end && *e >= '0' && *e <= '9') {
+			int exp = 0;
+			for (; e < end && *e >= '0' && *e <= '9'; ++e) {
+				if (exp < 10000) {
+					exp = exp * 10 + (*e - '0');
+				}
+			}
+			exponent += negativeExp ? -exp : exp;
+			p = e;
+		}
+	}
+	
+	if (significantDigits <= MAX_EXACT_DIGITS && exponent >= -MAX_POW10 && exponent <= MAX_POW10) {
+		double v = static_cast< double >(mantissa);
+		v = (exponent < 0) ? v / POW10[-exponent] : v * POW10[exponent];
+		value = negative ? -v : v;
+		
+	} else {
+		// slow path: strtod needs a NUL terminated copy of the number
+		char buffer[64];
+		std::size_t len = p - it;
+		if (len >= sizeof(buffer)) {
+			return false;
+		}
+		std::copy(it, p, buffer);
+		buffer[len] = '\0';
+		
+		char *parsedEnd;
+		value = std::strtod(buffer, &parsedEnd);
+		p = it + (parsedEnd - buffer);
+	}
+	
+	it = p;
+	return true;
+}
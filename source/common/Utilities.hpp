@@ -87,6 +87,19 @@ public:
 			const std::string &propValuePattern, bool icase = true) throw(std::runtime_error);
 	
 	static std::string repeat(const std::string &pattern, unsigned int nTimes);
+	
+	/**
+	 * Parses a decimal number (optionally signed, with fraction and
+	 * exponent) starting at \c it, without any allocation. The result is
+	 * the same of std::strtod: numbers with up to 15 significant digits and
+	 * small exponents take a fast exact path, the others fall back to it.
+	 * 
+	 * @param it beginning of the number, moved after it on success
+	 * @param end end of the buffer
+	 * @param value parsed number
+	 * @return false if no number starts at \c it
+	 */
+	static bool parseDouble(const char *&it, const char *end, double &value);
 };
 
 
@@ -145,4 +158,27 @@ public:
 	}
 };
 
+class BitUtils {
+	
+public:
+	
+	/**
+	 *
+	 * @param x
+	 * @return number of bits set in \c x
+	 */
+	inline
+	static int popCount(unsigned int x) {
+#ifdef __GNUC__
+		return __builtin_popcount(x);
+#else
+		int count = 0;
+		for (; x; x &= x - 1) {
+			++count;
+		}
+		return count;
+#endif
+	}
+};
+
 #endif /* UTILITIES_HPP_ */
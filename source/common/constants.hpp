@@ -16,6 +16,12 @@
 #define CMDLN_CONFFILE_NAME "positions.txt"
 #define CMDLN_VIDEO_MODE NONE
 #define CMDLN_MIN_VOXEL_SIZE 3.0
+#define CMDLN_THREADS 1
+#define CMDLN_BATCH_SIZE 1
+#define CMDLN_PREFETCH_DEPTH 256
+#define CMDLN_MESH_THREADS 1
+#define CMDLN_CHECKPOINT_RETENTION 1
+#define CMDLN_DEPTH_SWITCH -1
 
 /**
  * ALGORITHM SPECIFIC CONSTANTS
@@ -6,3 +6,180 @@
  */
 
 #include "CNCMoveIterator.hpp"
+
+#include <cctype>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "common/constants.hpp"
+
+const char * const CNCMoveIterator::COMPILED_SECTION = "COMPILED_POINTS";
+
+Eigen::Isometry3d CNCMove::getCutterIsometry() const {
+	
+	/** given move rototraslations are in respect of world basis so we have
+	 * to "merge" this two informations in order to find cutter rototraslation
+	 * in stock basis.
+	 *
+	 * When returned as eigen both these isometry are matrices that
+	 * converts point from stock/cutter coords to world ones: i.e. they
+	 * convert from stock/cutter basis to world basis; we have to create 
+	 * an isometry that converts from cutter coords to stock coords.
+	 * 
+	 * P_world = StockIsom_world * P_stock
+	 * P'_world = CutterIsom_world * P'_cutter
+	 * P''_stock = inverse(StockIsom_world) * P''_world
+	 * 
+	 * P3_stock = inverse(StockIsom_world) * CutterIsom_world * P3_cutter
+	 */
+	return STOCK.asEigen().inverse() * CUTTER.asEigen();
+}
+
+CNCMoveIterator::CNCMoveIterator(const boost::shared_ptr< MappedFile > &file,
+		std::size_t offset, bool compiled) :
+	file(file), pos(NULL), end(NULL), compiled(compiled)
+{
+	if (offset >= file->size()) {
+		return;
+	}
+	
+	pos = file->data() + offset;
+	end = file->data() + file->size();
+	
+	if (compiled) {
+		CompiledHeader header;
+		if (static_cast< std::size_t >(end - pos) < sizeof(header)) {
+			throw std::runtime_error("compiled moves header is truncated");
+		}
+		std::memcpy(&header, pos, sizeof(header));
+		pos += sizeof(header);
+		
+		if (header.magic != COMPILED_MAGIC || header.version != COMPILED_VERSION) {
+			throw std::runtime_error("unsupported compiled moves format");
+		}
+		if (header.nMoves != (end - pos) / COMPILED_RECORD_SIZE) {
+			throw std::runtime_error("compiled moves are truncated");
+		}
+	}
+	
+	readNext();
+}
+
+Eigen::Isometry3d CNCMoveIterator::getCutterIsometry() const {
+	if (!compiled) {
+		return move.getCutterIsometry();
+	}
+	
+	Eigen::Isometry3d isometry;
+	isometry.affine() = Eigen::Map< const Eigen::Matrix< double, 3, 4 > >(cutterIsometry);
+	isometry.makeAffine();
+	
+	return isometry;
+}
+
+void CNCMoveIterator::readNext() {
+	if (compiled) {
+		readNextRecord();
+	} else {
+		readNextLine();
+	}
+}
+
+void CNCMoveIterator::readNextRecord() {
+	
+	if (pos != NULL && static_cast< std::size_t >(end - pos) >= COMPILED_RECORD_SIZE) {
+		double values[N_VALUES];
+		std::memcpy(values, pos, sizeof(values));
+		std::memcpy(cutterIsometry, pos + sizeof(values), sizeof(cutterIsometry));
+		pos += COMPILED_RECORD_SIZE;
+		
+		move = CNCMove(
+				Rototraslation(Point3D(values[0], values[1], values[2]),
+						EulerAngles(values[3], values[4], values[5])),
+				Rototraslation(Point3D(values[6], values[7], values[8]),
+						EulerAngles(values[9], values[10], values[11]))
+		);
+		return;
+	}
+	
+	// no more moves: this is now an end iterator
+	pos = end = NULL;
+}
+
+void CNCMoveIterator::readNextLine() {
+	
+	while (pos != NULL && pos < end) {
+		const char *lineEnd = static_cast< const char * >(std::memchr(pos, '\n', end - pos));
+		if (lineEnd == NULL) {
+			lineEnd = end;
+		}
+		
+		const char *it = pos;
+		const char *next = (lineEnd < end) ? lineEnd + 1 : end;
+		
+		// skip leading blanks: empty lines and comments are ignored
+		while (it < lineEnd && std::isspace(static_cast< unsigned char >(*it))) {
+			++it;
+		}
+		if (it == lineEnd || *it == CONF_COMMENT_CHAR) {
+			pos = next;
+			continue;
+		}
+		
+		double values[N_VALUES];
+		int nValues = parseLine(it, lineEnd, values);
+		
+		if (nValues == N_VALUES) {
+			move = CNCMove(
+					Rototraslation(Point3D(values[0], values[1], values[2]),
+							EulerAngles(values[3], values[4], values[5])),
+					Rototraslation(Point3D(values[6], values[7], values[8]),
+							EulerAngles(values[9], values[10], values[11]))
+			);
+			pos = next;
+			return;
+		}
+		
+		// given line seems not to be a rototraslation -> states the error
+		if (nValues < 0) {
+			std::cerr << "bad rototraslation spec: " << std::string(it, lineEnd) << std::endl;
+		} else {
+			std::cerr << "not enough tokens for a rototraslation: " << nValues << std::endl;
+		}
+		break;
+	}
+	
+	// no more moves: this is now an end iterator
+	pos = end = NULL;
+}
+
+int CNCMoveIterator::parseLine(const char *it, const char *lineEnd, double values[N_VALUES]) {
+	int nValues = 0;
+	
+	while (true) {
+		// values are separated by any sequence of ';' and blanks
+		while (it < lineEnd && (*it == ';' || std::isspace(static_cast< unsigned char >(*it)))) {
+			++it;
+		}
+		if (it == lineEnd) {
+			return nValues;
+		}
+		
+		double value;
+		if (!StringUtils::parseDouble(it, lineEnd, value)) {
+			return -1;
+		}
+		
+		// a value must be followed by a separator
+		if (it < lineEnd && !(*it == ';' || std::isspace(static_cast< unsigned char >(*it)))) {
+			return -1;
+		}
+		
+		if (nValues < N_VALUES) {
+			values[nValues] = value;
+		}
+		++nValues;
+	}
+}
@@ -14,10 +14,10 @@
 #include <vector>
 
 #include <boost/shared_ptr.hpp>
-#include <boost/algorithm/string.hpp>
-#include <boost/algorithm/string/classification.hpp>
-#include <boost/regex.hpp>
-#include <boost/lexical_cast.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <Eigen/Geometry>
 
 #include "common/Rototraslation.hpp"
 #include "common/Utilities.hpp"
@@ -46,6 +46,13 @@ public:
 	 */
 	Rototraslation STOCK, CUTTER;
 	
+	/**
+	 *
+	 * @return the isometry that converts points from cutter coords to
+	 * stock ones
+	 */
+	Eigen::Isometry3d getCutterIsometry() const;
+	
 	/**
 	 * redefines the << operator for printing the rototraslation
 	 * @param os the output stream
@@ -58,120 +65,146 @@ public:
 		return os;
 	}
 	
-private:
-	static Point3D buildTraslation(std::vector< std::string >::iterator it) {
-		
-		double X = boost::lexical_cast<double>(*it++);
-		double Y = boost::lexical_cast<double>(*it++);
-		double Z = boost::lexical_cast<double>(*it++);
-		
-		return Point3D(X, Y, Z);
-		
-	}
-
-	static EulerAngles buildRotation(std::vector< std::string >::iterator it) {
-		
-		double ALPHA = boost::lexical_cast<double>(*it++);
-		double BETA = boost::lexical_cast<double>(*it++);
-		double GAMMA = boost::lexical_cast<double>(*it++);
-		
-		return EulerAngles(ALPHA, BETA, GAMMA);
-		
-	}
-
-	static const Rototraslation buildRototraslation(std::vector< std::string >::iterator it) {
-		
-		// then build rotation and traslation based on the split
-		Point3D traslation = CNCMove::buildTraslation(it);
-		EulerAngles rotation = CNCMove::buildRotation(it + 3);
-		
-		return Rototraslation(traslation, rotation);
-	}
-
-	friend std::istream &operator>>(std::istream &is, CNCMove &move) {
-		FileUtils::ReadData data;
-		try {
-			data = FileUtils::readNextValidLine(is);
-		} catch (const std::runtime_error &e) {
-			/* we are not sure that there is another valid line before EOF
-			 * so we have to catch any exception rised by readNextValidLine
-			 * and simply return from the method (no need to set failbit
-			 * because we simply reached eof)
-			 */
-			return is;
-		}
-		
-		// now we have to decode given line into a couple of Rototraslations
-		
-		/* it is not possible to use regexp here (apart from checking
-		 * string-correctness) because a valid regex would be "(?:\\s*([\\d\\.-]+);?){12}"
-		 * but in boost repeated captures are all discarded except for the last
-		 * one: this means no way to get all saved numbers.
-		 */
-		
-		/* the fastest approach is to to tokenize the string in a whole and then
-		 * go for conversion of every token (i.e. number)
-		 */
-		std::vector< std::string > tokens;
-		boost::split(tokens,
-				data.validLine,
-				boost::is_any_of("; "),
-				boost::token_compress_on
-		);
-		
-		if(tokens.size() == 12) {
-		
-			// then build rototraslation
-			try {
-				Rototraslation rt1, rt2;
-				rt1 = CNCMove::buildRototraslation(tokens.begin());
-				rt2 = CNCMove::buildRototraslation(tokens.begin() + 6);
-				move = CNCMove(rt1, rt2);
-				
-			} catch (const std::exception &e) {
-				std::cerr << "bad rototraslation spec: " << e.what() << std::endl;
-				is.seekg(data.lastReadPos, std::ios_base::beg);
-				is.setstate(std::ios_base::failbit);
-			}
-			
-		} else {
-			// given line seems not to be a rototraslation -> states the error
-			std::cerr << "not enough tokens for a rototraslation: " << tokens.size() << std::endl;
-			is.seekg(data.lastReadPos, std::ios_base::beg);
-			is.setstate(std::ios_base::failbit);
-		}
-
-		return is;
-	}
-	
 };
 
 /**
  * @class CNCMoveIterator
  *
- * iterator for CNC moves
+ * iterator for CNC moves. The positions file is memory-mapped and moves
+ * are parsed in place, one line at a time, without any allocation: the
+ * mapping is shared among the copies of the iterator and released with the
+ * last one. The iteration stops at the end of the file or at the first
+ * malformed line.
+ *
+ * Compiled toolpaths (see ToolpathCompiler) replace the [POINTS] section
+ * with a [COMPILED_POINTS] one: a header (magic, version, number of
+ * moves) followed by fixed-size records, each one holding the 12 values of
+ * a text line plus the 3x4 affine matrix (column-major) of the cutter
+ * isometry, so that moves are neither parsed nor converted.
  */
-class CNCMoveIterator : public std::istream_iterator<CNCMove> {
+class CNCMoveIterator : public std::iterator< std::input_iterator_tag, CNCMove > {
+	
+public:
+	typedef boost::iostreams::mapped_file_source MappedFile;
+	
+	/** name of the section holding compiled moves */
+	static const char * const COMPILED_SECTION;
+	
+	static const boost::uint32_t COMPILED_MAGIC = 0x424d4e43; // "CNMB"
+	static const boost::uint32_t COMPILED_VERSION = 1;
+	
+	/** number of values in a line of the [POINTS] section */
+	static const int N_VALUES = 12;
+	
+	/** number of values of the cutter isometry in a compiled record */
+	static const int N_ISOMETRY_VALUES = 12;
+	
+	/** header of the [COMPILED_POINTS] section */
+	struct CompiledHeader {
+		boost::uint32_t magic;
+		boost::uint32_t version;
+		boost::uint64_t nMoves;
+	};
+	
+	static const std::size_t COMPILED_RECORD_SIZE = (N_VALUES + N_ISOMETRY_VALUES) * sizeof(double);
 	
-	/** this variable is needed because we have to keep the object pointed
-	 * to by the smart_pointer alive until the iterator will be deleted
+private:	
+	/** this variable is needed because we have to keep the mapping alive
+	 * until the iterator will be deleted
 	 */
-	boost::shared_ptr< std::ifstream > stream;
+	boost::shared_ptr< MappedFile > file;
+	
+	/** next char to parse, NULL when the iterator reached the end */
+	const char *pos;
+	const char *end;
+	
+	bool compiled;
+	
+	CNCMove move;
+	
+	/** cutter isometry of the current move (compiled toolpaths only) */
+	double cutterIsometry[N_ISOMETRY_VALUES];
 	
 public:
 	/**
 	 * constructors
-	 * @param stream
+	 * @param file
+	 * @param offset position of the first move in the file
+	 * @param compiled True if moves are stored in a [COMPILED_POINTS] section
+	 * 
+	 * @throw std::runtime_error if compiled moves are not valid
 	 */
-	CNCMoveIterator(boost::shared_ptr<std::ifstream> stream) : 
-		std::istream_iterator<CNCMove>(*stream), stream(stream) {
-	}
+	CNCMoveIterator(const boost::shared_ptr< MappedFile > &file, std::size_t offset,
+			bool compiled = false);
 	
-	CNCMoveIterator() : std::istream_iterator<CNCMove>() {
+	CNCMoveIterator() : pos(NULL), end(NULL), compiled(false) {
 	}
 	
 	virtual ~CNCMoveIterator() { }
 	
+	const CNCMove &operator*() const {
+		return move;
+	}
+	
+	const CNCMove *operator->() const {
+		return &move;
+	}
+	
+	CNCMoveIterator &operator++() {
+		readNext();
+		return *this;
+	}
+	
+	CNCMoveIterator operator++(int) {
+		CNCMoveIterator old(*this);
+		readNext();
+		return old;
+	}
+	
+	/**
+	 * as for std::istream_iterator two iterators are equal if they both
+	 * reached the end or if they are at the same position of the same file
+	 */
+	bool operator==(const CNCMoveIterator &other) const {
+		return pos == other.pos;
+	}
+	
+	bool operator!=(const CNCMoveIterator &other) const {
+		return !(*this == other);
+	}
+	
+	/**
+	 *
+	 * @return the cutter isometry of the current move: compiled toolpaths
+	 * store it, otherwise it is computed (see CNCMove::getCutterIsometry)
+	 */
+	Eigen::Isometry3d getCutterIsometry() const;
+	
+private:
+	/**
+	 * reads the next move into #move, or moves to the end
+	 */
+	void readNext();
+	
+	/**
+	 * parses the next valid line into #move, or moves to the end
+	 */
+	void readNextLine();
+	
+	/**
+	 * decodes the next compiled record into #move, or moves to the end
+	 */
+	void readNextRecord();
+	
+	/**
+	 * parses a line of the [POINTS] section
+	 * @param it beginning of the line
+	 * @param lineEnd end of the line
+	 * @param values where parsed values are stored
+	 * @return the number of parsed values, -1 if the line is malformed
+	 */
+	static int parseLine(const char *it, const char *lineEnd, double values[N_VALUES]);
+	
 };
 
 
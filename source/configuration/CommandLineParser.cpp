@@ -24,6 +24,8 @@ CommandLineParser::CommandLineParser(int argc, char** argv) :
 	
 	this->helpAsked = vm.count("help");
 	this->paused = vm.count("paused");
+	this->sweep = vm.count("sweep");
+	this->weld = vm.count("weld");
 }
 
 CommandLineParser::~CommandLineParser() {
@@ -34,6 +36,38 @@ std::string CommandLineParser::getConfigFile() const {
 	return this->filename;
 }
 
+std::string CommandLineParser::getCompiledFile() const {
+	return this->compiledFile;
+}
+
+std::string CommandLineParser::getTraceFile() const {
+	return this->traceFile;
+}
+
+std::string CommandLineParser::getCheckpointFile() const {
+	return this->checkpointFile;
+}
+
+unsigned int CommandLineParser::getCheckpointStep() const {
+	return this->checkpointStep;
+}
+
+unsigned int CommandLineParser::getCheckpointMoves() const {
+	return this->checkpointMoves;
+}
+
+unsigned int CommandLineParser::getCheckpointSeconds() const {
+	return this->checkpointSeconds;
+}
+
+unsigned int CommandLineParser::getCheckpointRetention() const {
+	return this->checkpointRetention;
+}
+
+std::string CommandLineParser::getResumeFile() const {
+	return this->resumeFile;
+}
+
 float CommandLineParser::getMinVoxelSize() const {
 	return this->minVoxelSize;
 }
@@ -58,6 +92,38 @@ float CommandLineParser::getWaterThreshold() const {
 	return this->waterThreshold;
 }
 
+unsigned int CommandLineParser::getThreadsNumber() const {
+	return this->nThreads;
+}
+
+bool CommandLineParser::isSweepEnabled() const {
+	return this->sweep;
+}
+
+bool CommandLineParser::isWeldEnabled() const {
+	return this->weld;
+}
+
+unsigned int CommandLineParser::getBatchSize() const {
+	return this->batchSize;
+}
+
+unsigned int CommandLineParser::getPrefetchDepth() const {
+	return this->prefetchDepth;
+}
+
+unsigned int CommandLineParser::getCompactMoves() const {
+	return this->compactMoves;
+}
+
+int CommandLineParser::getDepthSwitch() const {
+	return this->depthSwitch;
+}
+
+unsigned int CommandLineParser::getMeshThreadsNumber() const {
+	return this->nMeshThreads;
+}
+
 void CommandLineParser::printUsage(std::ostream& os) const {
 	os << "Usage: " << PROG_NAME << " [options] pointsFile" << std::endl;
 	os << OPTIONS << std::endl;
@@ -64,12 +64,28 @@ private:
 	const std::string PROG_NAME;
 	
 	std::string filename;
+	std::string compiledFile;
+	std::string traceFile;
+	std::string checkpointFile;
+	std::string resumeFile;
 	VideoMode videoMode;
 	float minVoxelSize;
 	float waterFlux;
 	float waterThreshold;
+	unsigned int nThreads;
+	unsigned int batchSize;
+	unsigned int prefetchDepth;
+	unsigned int nMeshThreads;
+	unsigned int checkpointStep;
+	unsigned int checkpointMoves;
+	unsigned int checkpointSeconds;
+	unsigned int checkpointRetention;
+	unsigned int compactMoves;
+	int depthSwitch;
 	bool helpAsked;
 	bool paused;
+	bool sweep;
+	bool weld;
 	
 public:
 
@@ -91,6 +107,60 @@ public:
 	 */
 	std::string getConfigFile() const;
 
+	/**
+	 *
+	 * @return the path of the binary toolpath to compile the config file
+	 * into, empty if the simulation has to be run
+	 */
+	std::string getCompiledFile() const;
+
+	/**
+	 *
+	 * @return the path of the trace file to write, empty if tracing is
+	 * disabled
+	 */
+	std::string getTraceFile() const;
+
+	/**
+	 *
+	 * @return the path of the checkpoint to write, empty if no checkpoint
+	 * has to be written
+	 */
+	std::string getCheckpointFile() const;
+
+	/**
+	 *
+	 * @return the number of moves to mill before writing the checkpoint
+	 */
+	unsigned int getCheckpointStep() const;
+
+	/**
+	 *
+	 * @return the number of moves between periodic checkpoints (0 if
+	 * disabled)
+	 */
+	unsigned int getCheckpointMoves() const;
+
+	/**
+	 *
+	 * @return the number of seconds between periodic checkpoints (0 if
+	 * disabled)
+	 */
+	unsigned int getCheckpointSeconds() const;
+
+	/**
+	 *
+	 * @return the number of checkpoints kept
+	 */
+	unsigned int getCheckpointRetention() const;
+
+	/**
+	 *
+	 * @return the path of the checkpoint to resume milling from, empty to
+	 * begin from the first move
+	 */
+	std::string getResumeFile() const;
+
 	/**
 	 *
 	 * @return the minimum size of the voxel
@@ -109,6 +179,46 @@ public:
 	 */
 	float getWaterThreshold() const;
 
+	/**
+	 *
+	 * @return the number of threads used to mill each move
+	 */
+	unsigned int getThreadsNumber() const;
+
+	/**
+	 *
+	 * @return the number of moves milled in a single stock traversal
+	 */
+	unsigned int getBatchSize() const;
+
+	/**
+	 *
+	 * @return the number of moves read ahead of milling by a dedicated
+	 * thread (0 if moves are read by the milling thread)
+	 */
+	unsigned int getPrefetchDepth() const;
+
+	/**
+	 *
+	 * @return the number of moves between stock compactions (0 if the
+	 * stock is never compacted)
+	 */
+	unsigned int getCompactMoves() const;
+
+	/**
+	 *
+	 * @return the first depth whose voxels are tested against the cutter
+	 * bounding box (negative if it has to be chosen by profiling)
+	 */
+	int getDepthSwitch() const;
+
+	/**
+	 *
+	 * @return the number of threads building the geometries of the
+	 * changed leaves of the mesh
+	 */
+	unsigned int getMeshThreadsNumber() const;
+
 	/**
 	 *
 	 * @return True if help is asked, False otherwise
@@ -121,6 +231,19 @@ public:
 	 */
 	bool startPaused() const;
 
+	/**
+	 *
+	 * @return True if the cutter has to mill along the segments between moves
+	 */
+	bool isSweepEnabled() const;
+
+	/**
+	 *
+	 * @return True if the vertices of the marching cubes mesh have to be
+	 * welded
+	 */
+	bool isWeldEnabled() const;
+
 	/**
 	 *
 	 * @return the chosen video mode
@@ -149,9 +272,25 @@ private:
 				("config,c", bpo::value< std::string >(&filename)->default_value(CMDLN_CONFFILE_NAME), "position of the configuration file")
 				("vsize,s", bpo::value< float >(&minVoxelSize)->default_value(CMDLN_MIN_VOXEL_SIZE), "minimum voxel size: all voxel dimensions should be equal or less then specified value")
 				("video,v", bpo::value< VideoMode >(&videoMode)->default_value(CMDLN_VIDEO_MODE), "set video mode: 'box', 'mesh', 'none' (default)")
+				("threads,j", bpo::value< unsigned int >(&nThreads)->default_value(CMDLN_THREADS), "number of threads used to mill each move")
+				("batch,b", bpo::value< unsigned int >(&batchSize)->default_value(CMDLN_BATCH_SIZE), "number of moves milled in a single stock traversal")
+				("prefetch,q", bpo::value< unsigned int >(&prefetchDepth)->default_value(CMDLN_PREFETCH_DEPTH), "number of moves parsed ahead of milling by a dedicated thread (0 parses them in the milling thread)")
+				("compact,g", bpo::value< unsigned int >(&compactMoves)->default_value(0), "number of moves between compactions of the stock, merging untouched sibling voxels (0 never compacts it). The waste is approximated: milling a merged voxel may count slightly less waste than milling its siblings would")
+				("sat-depth,d", bpo::value< int >(&depthSwitch)->default_value(CMDLN_DEPTH_SWITCH), "first depth whose voxels are tested against the cutter bounding box instead of the separating axis test (negative chooses it profiling the first moves that mill some material: depths discard different voxels, so milling results may slightly differ from a run to another)")
+				("mesh-threads,k", bpo::value< unsigned int >(&nMeshThreads)->default_value(CMDLN_MESH_THREADS), "number of threads used to build the geometries of the changed mesh leaves")
 				("paused,p", "starts program in paused mode, you'll need to press RUN to start milling")
+				("sweep,w", "mills all the material met by the cutter moving between consecutive moves, not only at moves positions")
+				("weld,e", "welds the vertices shared by the marching cubes triangles, indexing them and smoothing their normals")
 				("wflux,f", bpo::value< float >(&waterFlux)->default_value(ALG_WATER_REMOTION_RATE), "set water removal rate (in u^3 of waste)")
 				("wthreshold,t", bpo::value< float >(&waterThreshold)->default_value(ALG_WATER_THRESHOLD), "set amount of waste to mill before enabling water (in u^3)")
+				("checkpoint,x", bpo::value< std::string >(&checkpointFile), "writes stock and milling progress to the given checkpoint file, as set by --checkpoint-at, --checkpoint-every and --checkpoint-seconds")
+				("checkpoint-at,a", bpo::value< unsigned int >(&checkpointStep)->default_value(0), "number of moves to mill before writing a checkpoint")
+				("checkpoint-every,y", bpo::value< unsigned int >(&checkpointMoves)->default_value(0), "number of moves between periodic checkpoints")
+				("checkpoint-seconds,i", bpo::value< unsigned int >(&checkpointSeconds)->default_value(0), "number of seconds between periodic checkpoints")
+				("checkpoint-keep,l", bpo::value< unsigned int >(&checkpointRetention)->default_value(CMDLN_CHECKPOINT_RETENTION), "number of checkpoints kept: the older ones are numbered from 1")
+				("resume,u", bpo::value< std::string >(&resumeFile), "resumes milling from the given checkpoint file, written with the same positions file and voxel size")
+				("trace,r", bpo::value< std::string >(&traceFile), "writes a Chrome trace (chrome://tracing) of milling and meshing phases to the given file")
+				("compile,o", bpo::value< std::string >(&compiledFile), "compiles the positions file into the given binary toolpath (usable as positions file) and exits")
 		;
 		
 		return description;
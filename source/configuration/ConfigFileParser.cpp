@@ -27,6 +27,7 @@ ConfigFileParser::ConfigFileParser(const std::string filename) :
 		FILENAME(filename), PARSERS(fillParsers()) {
 	
 	foundCutter = foundStock = foundPoints = false;
+	compiled = false;
 	
 	std::ifstream ifs;
 	FileUtils::openFile(filename, ifs);
@@ -78,22 +79,24 @@ const CutterDescription::ConstPtr ConfigFileParser::getCutterDescription() const
 }
 
 CNCMoveIterator ConfigFileParser::CNCMoveBegin() const {
-	boost::shared_ptr< std::ifstream > ifsp = boost::make_shared< std::ifstream >();
-	FileUtils::openFile(this->FILENAME, *ifsp);
-	
-	if (!ifsp->is_open()) {
+	boost::shared_ptr< CNCMoveIterator::MappedFile > file;
+	try {
+		file = boost::make_shared< CNCMoveIterator::MappedFile >(this->FILENAME);
+	} catch (const std::exception &e) {
 		throw std::runtime_error("File " + this->FILENAME + " is disappeared");
 	}
 	
-	ifsp->seekg(this->firstPointPos, std::ios_base::beg);
-	
-	return CNCMoveIterator(ifsp);
+	return CNCMoveIterator(file, this->firstPointPos, this->compiled);
 }
 
 CNCMoveIterator ConfigFileParser::CNCMoveEnd() const {
 	return CNCMoveIterator();
 }
 
+bool ConfigFileParser::isCompiled() const {
+	return this->compiled;
+}
+
 bool ConfigFileParser::foundAll() const {
 	return this->foundCutter && this->foundStock && this->foundPoints;
 }
@@ -212,6 +215,11 @@ void ConfigFileParser::sectionParser_points(std::ifstream& ifs) {
 	}
 }
 
-
-
+void ConfigFileParser::sectionParser_compiledPoints(std::ifstream& ifs) {
+	/* binary moves follow: points parser checks that nothing else has to
+	 * be read
+	 */
+	sectionParser_points(ifs);
+	this->compiled = true;
+}
 
@@ -34,6 +34,7 @@ class ConfigFileParser {
 	CutterDescription::ConstPtr cutter;
 	std::streamoff firstPointPos;
 	bool foundPoints, foundCutter, foundStock;
+	bool compiled;
 	
 public:
 	/**
@@ -70,6 +71,12 @@ public:
 	 */
 	CNCMoveIterator CNCMoveEnd() const;
 	
+	/**
+	 *
+	 * @return True if moves are stored in a [COMPILED_POINTS] section
+	 */
+	bool isCompiled() const;
+	
 private:
 	bool foundAll() const;
 	
@@ -98,11 +105,18 @@ private:
 	 */
 	void sectionParser_points(std::ifstream &);
 	
+	/**
+	 * parse the [COMPILED_POINTS] section
+	 * @param
+	 */
+	void sectionParser_compiledPoints(std::ifstream &);
+	
 	ParsersMap fillParsers() {
 		std::map< std::string, sectionParser > m;
 		m["TOOL"] = &ConfigFileParser::sectionParser_tool;
 		m["PRODUCT"] = &ConfigFileParser::sectionParser_product;
 		m["POINTS"] = &ConfigFileParser::sectionParser_points;
+		m[CNCMoveIterator::COMPILED_SECTION] = &ConfigFileParser::sectionParser_compiledPoints;
 		return m;
 	}
 	
@@ -0,0 +1,83 @@
+/*
+ * ToolpathCompiler.cpp
+ *
+ *  Created on: 17/ott/2026
+ *      Author: socket
+ */
+
+#include "ToolpathCompiler.hpp"
+
+#include <fstream>
+#include <string>
+
+#include <boost/algorithm/string.hpp>
+
+#include <Eigen/Geometry>
+
+#include "common/Utilities.hpp"
+#include "ConfigFileParser.hpp"
+#include "CNCMoveIterator.hpp"
+
+unsigned long ToolpathCompiler::compile(const std::string &positionsFile,
+		const std::string &compiledFile) throw(std::runtime_error) {
+	
+	// parsing the whole configuration also validates it
+	ConfigFileParser cfp(positionsFile);
+	if (cfp.isCompiled()) {
+		throw std::runtime_error(positionsFile + " is already compiled");
+	}
+	
+	std::ofstream ofs(compiledFile.c_str(), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+	if (!ofs.is_open()) {
+		throw std::runtime_error("can't write " + compiledFile);
+	}
+	
+	// 1- copy every line preceding the points section
+	std::ifstream ifs;
+	FileUtils::openFile(positionsFile, ifs);
+	
+	std::string line;
+	while (std::getline(ifs, line) && boost::trim_copy(line) != "[POINTS]") {
+		ofs << line << '\n';
+	}
+	ofs << '[' << CNCMoveIterator::COMPILED_SECTION << "]\n";
+	
+	// 2- header: the number of moves is known only at the end
+	CNCMoveIterator::CompiledHeader header;
+	header.magic = CNCMoveIterator::COMPILED_MAGIC;
+	header.version = CNCMoveIterator::COMPILED_VERSION;
+	header.nMoves = 0;
+	
+	std::streampos headerPos = ofs.tellp();
+	ofs.write(reinterpret_cast< const char * >(&header), sizeof(header));
+	
+	// 3- moves
+	double record[CNCMoveIterator::N_VALUES + CNCMoveIterator::N_ISOMETRY_VALUES];
+	for (CNCMoveIterator it = cfp.CNCMoveBegin(); it != cfp.CNCMoveEnd(); ++it) {
+		const Rototraslation *poses[] = { &it->STOCK, &it->CUTTER };
+		for (int i = 0; i < 2; ++i) {
+			record[6 * i + 0] = poses[i]->TRASLATION.getX();
+			record[6 * i + 1] = poses[i]->TRASLATION.getY();
+			record[6 * i + 2] = poses[i]->TRASLATION.getZ();
+			record[6 * i + 3] = poses[i]->ROTATION.ALPHA;
+			record[6 * i + 4] = poses[i]->ROTATION.BETA;
+			record[6 * i + 5] = poses[i]->ROTATION.GAMMA;
+		}
+		
+		Eigen::Map< Eigen::Matrix< double, 3, 4 > >(record + CNCMoveIterator::N_VALUES) =
+				it.getCutterIsometry().affine();
+		
+		ofs.write(reinterpret_cast< const char * >(record), sizeof(record));
+		header.nMoves++;
+	}
+	
+	ofs.seekp(headerPos);
+	ofs.write(reinterpret_cast< const char * >(&header), sizeof(header));
+	ofs.close();
+	
+	if (ofs.fail()) {
+		throw std::runtime_error("error writing " + compiledFile);
+	}
+	
+	return header.nMoves;
+}
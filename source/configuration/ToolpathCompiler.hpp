@@ -0,0 +1,41 @@
+/**
+ * ToolpathCompiler.hpp
+ *
+ *  Created on: 17/ott/2026
+ *      Author: socket
+ */
+
+#ifndef TOOLPATHCOMPILER_HPP_
+#define TOOLPATHCOMPILER_HPP_
+
+#include <string>
+#include <stdexcept>
+
+/**
+ * @class ToolpathCompiler
+ *
+ * converts a positions file into a compiled one: stock and tool sections
+ * are copied as they are while the [POINTS] section is replaced by a binary
+ * [COMPILED_POINTS] one (see CNCMoveIterator) holding every move together
+ * with its cutter isometry. A compiled file can be used wherever a positions
+ * file is expected, skipping parsing and isometry computation.
+ */
+class ToolpathCompiler {
+	
+public:
+	/**
+	 * compiles given positions file
+	 * 
+	 * @param positionsFile
+	 * @param compiledFile
+	 * @return the number of compiled moves
+	 * 
+	 * @throw std::runtime_error if the positions file is already compiled
+	 * or the compiled one cannot be written
+	 */
+	static unsigned long compile(const std::string &positionsFile,
+			const std::string &compiledFile) throw(std::runtime_error);
+	
+};
+
+#endif /* TOOLPATHCOMPILER_HPP_ */
@@ -13,6 +13,8 @@
 
 #include "configuration/ConfigFileParser.hpp"
 #include "configuration/CommandLineParser.hpp"
+#include "configuration/ToolpathCompiler.hpp"
+#include "common/Trace.hpp"
 #include "milling/MillingAlgorithm.hpp"
 #include "milling/Stock.hpp"
 #include "milling/cutters.hpp"
@@ -53,6 +55,18 @@ int main(int argc, char **argv) {
 	
 	std::string configFile = clp.getConfigFile();
 	
+	if (!clp.getCompiledFile().empty()) {
+		unsigned long nMoves = ToolpathCompiler::compile(configFile, clp.getCompiledFile());
+		cout << "Compiled " << nMoves << " moves into " << clp.getCompiledFile() << endl;
+		return 0;
+	}
+	
+	if (!clp.getTraceFile().empty()) {
+		// before any traced thread is started
+		Trace::enable(clp.getTraceFile());
+		Trace::nameThread("main");
+	}
+	
 	ConfigFileParser cfp(configFile);
 	
 	// **** BUILD STOCK **** //
@@ -68,24 +82,31 @@ int main(int argc, char **argv) {
 			break;
 			
 		case CommandLineParser::MESH:
-			mesher = boost::make_shared< MarchingCubeMesher >(*cfp.getStockDescription());
+			mesher = boost::make_shared< MarchingCubeMesher >(*cfp.getStockDescription(),
+					clp.getMeshThreadsNumber(), clp.isWeldEnabled());
 			break;
 			
 		case CommandLineParser::BOX:
-			mesher = boost::make_shared< VoxelMesher >(*cfp.getStockDescription());
+			mesher = boost::make_shared< VoxelMesher >(*cfp.getStockDescription(),
+					clp.getMeshThreadsNumber());
 			break;
 			
 		default:
 			throw std::runtime_error("Unknonw video mode");
 	}
-	Stock::Ptr stock = boost::make_shared< Stock >(*cfp.getStockDescription(), max_depth, mesher);
+	Stock::Ptr stock = boost::make_shared< Stock >(*cfp.getStockDescription(), max_depth, mesher,
+			clp.getThreadsNumber(), clp.getDepthSwitch());
 	
 	// **** BUILD CUTTER **** //
 	Cutter::Ptr cutter = Cutter::buildCutter(*cfp.getCutterDescription());
 	
 	// **** BUILD MILLING ALGORITHM **** //
+	CheckpointConf checkpointConf(clp.getCheckpointFile(), clp.getCheckpointStep(),
+			clp.getCheckpointMoves(), clp.getCheckpointSeconds(), clp.getCheckpointRetention());
 	MillingAlgorithmConf millingConf(stock, cutter, cfp.CNCMoveBegin(), cfp.CNCMoveEnd(),
-			clp.getWaterFlux(), clp.getWaterThreshold());
+			clp.getWaterFlux(), clp.getWaterThreshold(), clp.getBatchSize(),
+			clp.isSweepEnabled(), clp.getPrefetchDepth(),
+			checkpointConf, clp.getResumeFile(), clp.getCompactMoves());
 	MillingAlgorithm::Ptr algorithm = boost::make_shared< MillingAlgorithm >(millingConf);
 	
 	// **** BUILD MILLER RUNNABLE **** //
@@ -141,6 +162,13 @@ int main(int argc, char **argv) {
 	controller->stop(); // ... just in case someone forgot to call it ...
 
 	millerThrd.join();
+	
+	Trace::write();
+	
+	if (clp.getPrefetchDepth() > 0) {
+		cout << "Milling waited " << algorithm->getPrefetchStalls()
+				<< " times for moves to be read" << endl;
+	}
 
 	return 0;
 }
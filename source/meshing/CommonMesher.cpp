@@ -7,12 +7,16 @@
 
 #include "CommonMesher.hpp"
 
+#include <stdexcept>
+
 #include <osg/BoundingBox>
 
+#include "common/Trace.hpp"
 #include "MeshingUtils.hpp"
 
 CommonMesher::CommonMesher(const StockDescription& stock,
-		LeafNodeCallback *lnc, unsigned int maxLeafSize, unsigned int maxDepth) :
+		LeafNodeCallback *lnc, unsigned int maxLeafSize, unsigned int maxDepth,
+		unsigned int nThreads) :
 		HALF_EXTENTS(stock.getGeometry()->asEigen() * 0.5),
 		meshOctree(
 				osg::BoundingBoxd(
@@ -23,13 +27,22 @@ CommonMesher::CommonMesher(const StockDescription& stock,
 				maxLeafSize,
 				maxDepth
 		)
-{ }
+{
+	if (nThreads <= 0)
+		throw std::invalid_argument("thread number should be >0");
+	
+	if (nThreads > 1) {
+		pool.reset(new WorkStealingPool(nThreads, "mesher worker"));
+	}
+}
 
 CommonMesher::~CommonMesher() {
 }
 
 Mesh::Ptr CommonMesher::buildMesh(const StoredData &data) {
 	
+	Trace::Scope scope("CommonMesher::buildMesh", "meshing");
+	
 	/* using an octree it's better to start freeing space and then appending
 	 * new leaves. However if a leaf appears in both sequences there will be
 	 * an inconsistency: check this with an assert on the reference count
@@ -58,7 +71,8 @@ Mesh::Ptr CommonMesher::buildMesh(const StoredData &data) {
 		 * even if this leaf has been placed in these queue because it
 		 * was intersecting & not contained, it may have been processed
 		 * again (during the current meshing) by the miller thread, that
-		 * deleted all its corners
+		 * deleted all its corners: that's why the shape of the voxel is
+		 * read from the snapshot kept in *dataIt
 		 */
 		
 		if(dataIt->vinfo->hasGraphics()) {
@@ -70,7 +84,7 @@ Mesh::Ptr CommonMesher::buildMesh(const StoredData &data) {
 			// current data has not been displayed yet...
 			const ShiftedBox::ConstPtr &sbox = dataIt->sbox;
 			
-			if(dataIt->vinfo->isIntersecting() ||
+			if(dataIt->isIntersecting() ||
 					MeshingUtils::isBorderVoxel(HALF_EXTENTS, *sbox)) {
 				// ... and we have to display it, so add to the data structure
 				
@@ -80,5 +94,8 @@ Mesh::Ptr CommonMesher::buildMesh(const StoredData &data) {
 		}
 	}
 	
+	// build the geometries now, instead of leaving them to the traversal
+	meshOctree.updateDirtyLeaves(pool.get());
+	
 	return boost::make_shared< Mesh >(meshOctree.getRoot());
 }
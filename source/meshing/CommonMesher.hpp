@@ -10,6 +10,8 @@
 
 #include "Mesher.hpp"
 
+#include <boost/scoped_ptr.hpp>
+
 #include <Eigen/Geometry>
 
 #include <osg/Group> 
@@ -32,6 +34,9 @@ private:
 	const Eigen::Vector3d HALF_EXTENTS;
 	MeshOctree meshOctree;
 	
+	/** NULL if leaves are meshed by the update thread only */
+	boost::scoped_ptr< WorkStealingPool > pool;
+	
 public:
 	/**
 	 * constructor
@@ -40,9 +45,12 @@ public:
 	 * @param lnc the callback to insert nodes
 	 * @param maxLeafSize
 	 * @param maxDepth
+	 * @param nThreads number of threads building the geometries of the
+	 * changed leaves (update thread included)
 	 */
 	CommonMesher(const StockDescription &stock, LeafNodeCallback *lnc,
-			unsigned int maxLeafSize, unsigned int maxDepth = 32);
+			unsigned int maxLeafSize, unsigned int maxDepth = 32,
+			unsigned int nThreads = 1);
 	virtual ~CommonMesher();
 	
 	/**
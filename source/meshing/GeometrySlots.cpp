@@ -0,0 +1,101 @@
+/*
+ * GeometrySlots.cpp
+ *
+ *  Created on: 17/ott/2026
+ *      Author: socket
+ */
+
+#include "GeometrySlots.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+GeometrySlots::GeometrySlots() : sorted(true), size(0), used(0) {
+}
+
+GeometrySlots::Range GeometrySlots::append(Key key, unsigned int count) {
+	assert(count > 0);
+
+	Range range(size, count);
+	size += count;
+	used += count;
+
+	if (!owned.empty() && std::less< Key >()(key, owned.back().first)) {
+		sorted = false;
+	}
+	owned.push_back(std::make_pair(key, range));
+
+	return range;
+}
+
+GeometrySlots::Range GeometrySlots::allocate(Key key, unsigned int count) {
+	assert(count > 0);
+
+	OwnedRanges::iterator ownedIt = findOwned(key);
+	assert(ownedIt == owned.end() || ownedIt->first != key);
+
+	Range range(size, count);
+
+	// best fit among the free ranges, otherwise append
+	FreeRanges::iterator freeIt = freeRanges.lower_bound(count);
+	if (freeIt != freeRanges.end()) {
+		range.first = freeIt->second;
+
+		unsigned int left = freeIt->first - count;
+		freeRanges.erase(freeIt);
+		if (left > 0) {
+			freeRanges.insert(std::make_pair(left, range.first + count));
+		}
+	} else {
+		size += count;
+	}
+
+	used += count;
+	owned.insert(ownedIt, std::make_pair(key, range));
+
+	return range;
+}
+
+bool GeometrySlots::find(Key key, Range &range) {
+	OwnedRanges::iterator ownedIt = findOwned(key);
+	if (ownedIt == owned.end() || ownedIt->first != key) {
+		return false;
+	}
+
+	range = ownedIt->second;
+	return true;
+}
+
+bool GeometrySlots::release(Key key, Range &range) {
+	OwnedRanges::iterator ownedIt = findOwned(key);
+	if (ownedIt == owned.end() || ownedIt->first != key) {
+		return false;
+	}
+
+	range = ownedIt->second;
+	owned.erase(ownedIt);
+
+	used -= range.count;
+	freeRanges.insert(std::make_pair(range.count, range.first));
+
+	return true;
+}
+
+unsigned int GeometrySlots::getSize() const {
+	return size;
+}
+
+bool GeometrySlots::isFragmented() const {
+	unsigned int freePrimitives = size - used;
+	return freePrimitives > MIN_FRAGMENTATION && freePrimitives > used;
+}
+
+GeometrySlots::OwnedRanges::iterator GeometrySlots::findOwned(Key key) {
+	if (!sorted) {
+		std::sort(owned.begin(), owned.end(), &GeometrySlots::compareOwned);
+		sorted = true;
+	}
+
+	return std::lower_bound(owned.begin(), owned.end(),
+			std::make_pair(key, Range()), &GeometrySlots::compareOwned);
+}
@@ -0,0 +1,136 @@
+/**
+ * GeometrySlots.hpp
+ *
+ *  Created on: 17/ott/2026
+ *      Author: socket
+ */
+
+#ifndef GEOMETRYSLOTS_HPP_
+#define GEOMETRYSLOTS_HPP_
+
+#include <functional>
+#include <map>
+#include <utility>
+#include <vector>
+
+/**
+ * @class GeometrySlots
+ *
+ * Keeps track of the primitives of a geometry owned by each element of a
+ * leaf, so that the primitives of a single element can be replaced in
+ * place without rebuilding the whole geometry. Every element owns a range
+ * of consecutive primitives; released ranges are kept in a free list and
+ * reused by the following allocations that fit into them.
+ *
+ * This class only does the bookkeeping: the owner of the geometry has to
+ * grow its arrays up to #getSize primitives and to blank the unused ones.
+ */
+class GeometrySlots {
+
+public:
+	typedef const void * Key;
+
+	/**
+	 * range of primitives
+	 */
+	struct Range {
+		Range() : first(0), count(0) { }
+		Range(unsigned int first, unsigned int count) : first(first), count(count) { }
+
+		unsigned int first;
+		unsigned int count;
+	};
+
+private:
+	/** free primitives tolerated even in almost empty geometries */
+	static const unsigned int MIN_FRAGMENTATION = 32;
+
+	typedef std::pair< Key, Range > OwnedRange;
+	/** sorted by key, unless #sorted is false */
+	typedef std::vector< OwnedRange > OwnedRanges;
+	/** free ranges sorted by size */
+	typedef std::multimap< unsigned int, unsigned int > FreeRanges;
+
+	OwnedRanges owned;
+	bool sorted;
+	FreeRanges freeRanges;
+
+	/** number of primitives of the geometry */
+	unsigned int size;
+	/** number of primitives owned by an element */
+	unsigned int used;
+
+public:
+	GeometrySlots();
+
+	/**
+	 * gives the ownership of some primitives at the end of the geometry to
+	 * an element: the element must not own other primitives. Elements are
+	 * sorted only when searched, so this is the fastest way to fill a
+	 * geometry from scratch.
+	 *
+	 * @param key the element
+	 * @param count the number of primitives needed by the element (>0)
+	 * @return the primitives of the element: they exceed #getSize before
+	 * this call
+	 */
+	Range append(Key key, unsigned int count);
+
+	/**
+	 * gives the ownership of some primitives to an element, reusing the
+	 * free ones if possible: the element must not own other primitives
+	 *
+	 * @param key the element
+	 * @param count the number of primitives needed by the element (>0)
+	 * @return the primitives of the element: they may exceed #getSize
+	 * before this call
+	 */
+	Range allocate(Key key, unsigned int count);
+
+	/**
+	 *
+	 * @param key the element
+	 * @param range filled with the primitives of the element
+	 * @return false if the element owns no primitive
+	 */
+	bool find(Key key, Range &range);
+
+	/**
+	 * puts the primitives of the given element in the free list
+	 *
+	 * @param key the element
+	 * @param range filled with the released primitives, that should be blanked
+	 * @return false if the element owns no primitive
+	 */
+	bool release(Key key, Range &range);
+
+	/**
+	 *
+	 * @return the number of primitives of the geometry
+	 */
+	unsigned int getSize() const;
+
+	/**
+	 *
+	 * @return True if most of the primitives of the geometry are free, so
+	 * that the geometry should be rebuilt from scratch
+	 */
+	bool isFragmented() const;
+
+private:
+	/**
+	 *
+	 * @param key
+	 * @return the first owned range whose key is not less than the given one
+	 */
+	OwnedRanges::iterator findOwned(Key key);
+
+	/**
+	 * orders by key
+	 */
+	static bool compareOwned(const OwnedRange &first, const OwnedRange &second) {
+		return std::less< Key >()(first.first, second.first);
+	}
+};
+
+#endif /* GEOMETRYSLOTS_HPP_ */
@@ -15,6 +15,7 @@
 #include <osg/Geode>
 #include <osg/NodeCallback>
 
+#include "common/Trace.hpp"
 #include "LeafNodeData.hpp"
 #include "MeshingUtils.hpp"
 
@@ -23,10 +24,12 @@
  *
  * Class used to convert LeafNodeData stored inside a node into a graphic
  * object. This conversion will be performed only each time data has been
- * flagged as dirty by MeshOctree methods.
+ * flagged as dirty by MeshOctree methods: the graphic object is patched
+ * if the callback supports it, otherwise it is rebuilt.
  * Pay attention that a single istance of this object will be attached
  * to all needed nodes so class attributes may be used to share informations
- * between different nodes.
+ * between different nodes: they must not be changed while building or
+ * patching nodes, since MeshOctree may do it on many leaves in parallel.
  */
 class LeafNodeCallback : boost::noncopyable, public osg::NodeCallback {
 	
@@ -50,28 +53,87 @@ public:
 		LeafNodeData *data = MeshingUtils::getUserData< LeafNodeData >(group);
 		
 		if (data->isDirty()) {
-			/* we have to rebuild mesh based on current leaf infos
-			 */
-			osg::ref_ptr< osg::Node > childNode;
-			if (data->isEmpty()) {
-				childNode = new osg::Geode;
-			} else {
-				childNode = buildNode(*data);
-			}
-			
-			assert(group->getNumChildren() == 1);
-			group->setChild(NODE_IDX, childNode.get());
-			
-			data->clean();
-			
-			group->setDataVariance(osg::Node::STATIC);
+			swapNode(group, prepareNode(group));
 		} // else, do nothing
 		
 		this->traverse(node, nv);
 	}
 	
+	/**
+	 * computes the node to be displayed for a dirty leaf. It doesn't change
+	 * the scene graph, so it can be called on many leaves in parallel.
+	 *
+	 * @param group the leaf
+	 * @return the node to be displayed: it may be the current one, patched
+	 */
+	osg::ref_ptr< osg::Node > prepareNode(osg::Group *group) {
+		LeafNodeData *data = MeshingUtils::getUserData< LeafNodeData >(group);
+		assert(data->isDirty());
+		assert(group->getNumChildren() == 1);
+		
+		/* we have to rebuild mesh based on current leaf infos, unless
+		 * the current one can be patched with the changed elements
+		 */
+		if (data->isEmpty()) {
+			return new osg::Geode;
+		}
+		
+		osg::Node *currNode = group->getChild(NODE_IDX);
+		if (patchNode(currNode, *data)) {
+			return currNode;
+		}
+		
+		Trace::Scope scope("leaf geometry rebuild", "visualization");
+		return buildNode(*data);
+	}
+	
+	/**
+	 * displays the node prepared for a dirty leaf: it must be called by the
+	 * update thread
+	 *
+	 * @param group the leaf
+	 * @param node the node returned by #prepareNode
+	 */
+	void swapNode(osg::Group *group, osg::Node *node) {
+		LeafNodeData *data = MeshingUtils::getUserData< LeafNodeData >(group);
+		
+		if (node == group->getChild(NODE_IDX)) {
+			commitNode(node);
+		} else {
+			group->setChild(NODE_IDX, node);
+		}
+		
+		data->clean();
+		
+		group->setDataVariance(osg::Node::STATIC);
+	}
+	
 	virtual osg::ref_ptr< osg::Node > buildNode(const LeafNodeData &data) =0;
 	
+	/**
+	 * updates the node built for the data with the elements changed since
+	 * the data was cleaned, without rebuilding it. By default nodes can't
+	 * be patched.
+	 * Patches of different nodes may run in parallel, so only the node
+	 * itself may be changed: notifying the scene graph is left to
+	 * #commitNode.
+	 *
+	 * @param node the node currently displayed for the data
+	 * @param data
+	 * @return false if the node can't be patched and has to be rebuilt
+	 */
+	virtual bool patchNode(osg::Node *, const LeafNodeData &) {
+		return false;
+	}
+	
+	/**
+	 * makes the changes of a patched node visible, it is called by the
+	 * update thread
+	 *
+	 * @param node
+	 */
+	virtual void commitNode(osg::Node *) { }
+	
 protected:
 	virtual ~LeafNodeCallback() { }
 };
@@ -19,17 +19,23 @@ OctreeNodeData::NodeDataType LeafNodeData::getType() const {
 
 GraphicData::Elm LeafNodeData::insertElm(const GraphicData& info) {
 	setDirty(); ++storedElms;
-	return elements.insert(elements.end(), info);
+	GraphicData::Elm elm = elements.insert(elements.end(), info);
+	changedElms.insert(&*elm);
+	
+	return elm;
 }
 
 void LeafNodeData::deleteElm(const GraphicData::Elm& ref) {
 	setDirty(); --storedElms;
+	changedElms.erase(&*ref);
+	removedElms.insert(&*ref);
 	elements.erase(ref);
 }
 
 void LeafNodeData::updateElm(const GraphicData::Elm& ref,
 		const GraphicData& info) {
 	setDirty();
+	changedElms.insert(&*ref);
 	*ref = info;
 }
 
@@ -46,6 +52,14 @@ GraphicData::List& LeafNodeData::getElements() {
 	return this->elements;
 }
 
+const LeafNodeData::ElmSet& LeafNodeData::getChangedElms() const {
+	return this->changedElms;
+}
+
+const LeafNodeData::ElmSet& LeafNodeData::getRemovedElms() const {
+	return this->removedElms;
+}
+
 bool LeafNodeData::isDirty() const {
 	return this->dirty;
 }
@@ -53,6 +67,8 @@ bool LeafNodeData::isDirty() const {
 void LeafNodeData::clean() {
 	assert(isDirty());
 	this->dirty = false;
+	this->changedElms.clear();
+	this->removedElms.clear();
 }
 
 bool LeafNodeData::isEmpty() const {
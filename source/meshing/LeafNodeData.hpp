@@ -10,6 +10,7 @@
 
 #include <utility>
 #include <list>
+#include <set>
 
 #include "OctreeNodeData.hpp"
 #include "milling/graphics_info.hpp"
@@ -21,6 +22,12 @@
  */
 class LeafNodeData: public OctreeNodeData {
 	
+public:
+	/**
+	 * addresses of the elements: they are only meant to identify the
+	 * elements, since the removed ones may be already destroyed
+	 */
+	typedef std::set< const GraphicData * > ElmSet;
 	
 private:
 	GraphicData::List elements;
@@ -36,6 +43,11 @@ private:
 	
 	bool dirty;
 	
+	/** elements inserted or updated since the last #clean */
+	ElmSet changedElms;
+	/** elements deleted since the last #clean */
+	ElmSet removedElms;
+	
 public:
 	/**
 	 * constructor
@@ -87,6 +99,21 @@ public:
 	const GraphicData::List &getElements() const;
 	GraphicData::List &getElements();
 	
+	/**
+	 *
+	 * @return the elements inserted or updated since the data was cleaned:
+	 * they are still contained in #getElements
+	 */
+	const ElmSet &getChangedElms() const;
+	
+	/**
+	 *
+	 * @return the elements deleted since the data was cleaned. The address
+	 * of a deleted element may have been reused by an inserted one, so
+	 * deletions have to be processed before changes
+	 */
+	const ElmSet &getRemovedElms() const;
+	
 	bool isDirty() const;
 	void clean();
 	
@@ -19,13 +19,24 @@
 class MarchingCubeMesher : public CommonMesher {
 	
 private:
+	static const unsigned int DEFAULT_MAX_DEPTH = 32;
 	static const unsigned int DEFAULT_LEAF_SIZE = 300;
 	
 public:
-	MarchingCubeMesher(const StockDescription& stock) :
+	/**
+	 * constructor
+	 *
+	 * @param stock
+	 * @param nThreads number of threads building the leaves geometries
+	 * @param weldVertices if true triangles share their vertices
+	 */
+	MarchingCubeMesher(const StockDescription& stock, unsigned int nThreads = 1,
+			bool weldVertices = false) :
 		CommonMesher(stock,
-				new MarchingCubeMesherCallback(stock),
-				DEFAULT_LEAF_SIZE
+				new MarchingCubeMesherCallback(stock, weldVertices),
+				DEFAULT_LEAF_SIZE,
+				DEFAULT_MAX_DEPTH,
+				nThreads
 		)
 	{ }
 	
@@ -7,14 +7,18 @@
 
 #include "MeshOctree.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <climits>
 
+#include <boost/bind.hpp>
+
 #include <osg/Group>
 #include <osg/Geode>
 #include <osg/PositionAttitudeTransform>
 #include <osg/ShapeDrawable>
 
+#include "common/Trace.hpp"
 #include "visualizer/VisualizationUtils.hpp"
 #include "MeshingUtils.hpp"
 #include "BranchNodeData.hpp"
@@ -35,6 +39,8 @@ MeshOctree::~MeshOctree() {
 }
 
 bool MeshOctree::addData(const GraphicData& data) {
+	Trace::Scope scope("MeshOctree::addData", "meshing");
+	
 	// build given element bounding box
 	osg::BoundingBoxd bbox = data.sbox->asBoundingBox();
 	
@@ -52,12 +58,14 @@ bool MeshOctree::addData(const GraphicData& data) {
 
 void MeshOctree::updateData(const GraphicPointer& ref, const GraphicData& gdata) {
 	LeafNodeData *lnd = MeshingUtils::getUserData< LeafNodeData >(ref.node.get());
+	markDirty(ref.node->asGroup(), *lnd);
 	lnd->updateElm(ref.item, gdata);
 	ref.node->setDataVariance(osg::Node::DYNAMIC);
 }
 
 void MeshOctree::removeData(const GraphicPointer& ref) {
 	LeafNodeData *lnd = MeshingUtils::getUserData< LeafNodeData >(ref.node.get());
+	markDirty(ref.node->asGroup(), *lnd);
 	lnd->deleteElm(ref.item);
 	ref.node->setDataVariance(osg::Node::DYNAMIC);
 }
@@ -66,6 +74,43 @@ osg::Group* MeshOctree::getRoot() {
 	return this->ROOT.get();
 }
 
+void MeshOctree::updateDirtyLeaves(WorkStealingPool *pool) {
+	if (pool == NULL) {
+		dirtyLeaves.clear();
+		return;
+	}
+	
+	Trace::Scope scope("MeshOctree::updateDirtyLeaves", "meshing");
+	
+	// some leaves may have been pushed after becoming dirty
+	std::vector< osg::Group * > leaves;
+	std::vector< osg::ref_ptr< osg::Group > >::const_iterator grpIt = dirtyLeaves.begin();
+	for (; grpIt != dirtyLeaves.end(); ++grpIt) {
+		OctreeNodeData *nodeData = MeshingUtils::getUserData< OctreeNodeData >(grpIt->get());
+		if (nodeData->getType() == OctreeNodeData::LeafLODData &&
+				static_cast< LeafNodeData * >(nodeData)->isDirty()) {
+			leaves.push_back(grpIt->get());
+		}
+	}
+	
+	// two tasks must not work on the same leaf
+	std::sort(leaves.begin(), leaves.end());
+	leaves.erase(std::unique(leaves.begin(), leaves.end()), leaves.end());
+	
+	std::vector< osg::ref_ptr< osg::Node > > nodes(leaves.size());
+	WorkStealingPool::TaskGroup group;
+	for (unsigned int i = 0; i < leaves.size(); ++i) {
+		pool->submit(group, boost::bind(&MeshOctree::prepareLeaf, this, leaves[i], &nodes[i]));
+	}
+	pool->wait(group);
+	
+	for (unsigned int i = 0; i < leaves.size(); ++i) {
+		groupCallback->swapNode(leaves[i], nodes[i].get());
+	}
+	
+	dirtyLeaves.clear();
+}
+
 osg::ref_ptr<osg::Group> MeshOctree::createLeafGrp(const osg::BoundingBoxd& bbox, unsigned char depth) {
 	osg::ref_ptr< osg::Group > grp = new osg::Group;
 
@@ -80,6 +125,9 @@ osg::ref_ptr<osg::Group> MeshOctree::createLeafGrp(const osg::BoundingBoxd& bbox
 	// create child geode (stub) and add to it (because groupCallback expects it)
 	grp->addChild(new osg::Geode);
 	
+	// new leaves are dirty
+	dirtyLeaves.push_back(grp);
+	
 	return grp.get();
 }
 
@@ -158,6 +206,7 @@ void MeshOctree::processLeafGrp(osg::Group* grp, const osg::BoundingBoxd&,
 	
 	// leaf should be inserted into this data
 	LeafNodeData *leafData = MeshingUtils::getUserData< LeafNodeData >(grp);
+	markDirty(grp, *leafData);
 	
 	GraphicData::Elm elm = leafData->insertElm(data);
 	data.vinfo->setGraphics(GraphicPointer(elm, grp));
@@ -178,3 +227,13 @@ void MeshOctree::processLeafGrp(osg::Group* grp, const osg::BoundingBoxd&,
 	}
 }
 
+void MeshOctree::markDirty(osg::Group* grp, const LeafNodeData& data) {
+	// dirty leaves have already been collected
+	if (!data.isDirty()) {
+		dirtyLeaves.push_back(grp);
+	}
+}
+
+void MeshOctree::prepareLeaf(osg::Group* grp, osg::ref_ptr< osg::Node >* node) {
+	*node = groupCallback->prepareNode(grp);
+}
@@ -9,11 +9,13 @@
 #define MESHOCTREE_HPP_
 
 #include <utility>
+#include <vector>
 
 #include <osg/LOD>
 #include <osg/BoundingBox>
 
 #include "milling/graphics_info.hpp"
+#include "threading/WorkStealingPool.hpp"
 #include "LeafNodeData.hpp"
 #include "LeafNodeCallback.hpp"
 
@@ -37,6 +39,9 @@ private:
 	NodeDataProcessers PROCESSERS[2];
 	osg::ref_ptr< osg::Group > ROOT;
 	
+	/** leaves that became dirty since the last #updateDirtyLeaves */
+	std::vector< osg::ref_ptr< osg::Group > > dirtyLeaves;
+	
 public:
 	/**
 	 * constructor
@@ -78,6 +83,15 @@ public:
 	 */
 	osg::Group * getRoot();
 	
+	/**
+	 * builds the nodes of the dirty leaves in parallel, then displays them.
+	 * It must be called by the update thread. Without a pool the leaves
+	 * are left to their callback, that updates them while traversed.
+	 *
+	 * @param pool may be NULL
+	 */
+	void updateDirtyLeaves(WorkStealingPool *pool);
+	
 private:
 	osg::ref_ptr< osg::Group > createLeafGrp(const osg::BoundingBoxd &bbox, unsigned char depth);
 	osg::ref_ptr< LeafNodeData > pushGrp(osg::Group *lod);
@@ -85,6 +99,22 @@ private:
 	void processBranchGrp(osg::Group *lod, const osg::BoundingBoxd &bbox, const GraphicData &data);
 	void processLeafGrp(osg::Group *lod, const osg::BoundingBoxd &bbox, const GraphicData &data);
 	
+	/**
+	 * keeps track of a leaf that is going to be changed
+	 *
+	 * @param grp
+	 * @param data the data of the leaf, before the change
+	 */
+	void markDirty(osg::Group *grp, const LeafNodeData &data);
+	
+	/**
+	 * task computing the node of a dirty leaf
+	 *
+	 * @param grp
+	 * @param node filled with the node to be displayed
+	 */
+	void prepareLeaf(osg::Group *grp, osg::ref_ptr< osg::Node > *node);
+	
 };
 
 #endif /* MESHOCTREE_HPP_ */
@@ -20,6 +20,7 @@
 class VoxelMesher : public CommonMesher {
 	
 private:
+	static const unsigned int DEFAULT_MAX_DEPTH = 32;
 	static const unsigned int DEFAULT_LEAF_SIZE = 400;
 	
 public:
@@ -27,11 +28,14 @@ public:
 	 * constructor
 	 *
 	 * @param stock
+	 * @param nThreads number of threads building the leaves geometries
 	 */
-	VoxelMesher(const StockDescription& stock) :
+	VoxelMesher(const StockDescription& stock, unsigned int nThreads = 1) :
 		CommonMesher(stock,
 				new BoxMesherCallback(stock),
-				DEFAULT_LEAF_SIZE
+				DEFAULT_LEAF_SIZE,
+				DEFAULT_MAX_DEPTH,
+				nThreads
 		)
 	{ }
 	
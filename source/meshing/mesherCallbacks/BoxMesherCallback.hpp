@@ -105,7 +105,7 @@ public:
 			for (; fit != FaceIterator::end(); ++fit) {
 				
 				if (! (Face::isBorderFace(*fit, STOCK_HALF_EXTENTS, *dataIt->sbox)
-						|| dataIt->vinfo->isIntersecting()
+						|| dataIt->isIntersecting()
 					)) {
 					continue;
 				}
@@ -7,19 +7,365 @@
 
 #include "MarchingCubeMesherCallback.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <cstring>
+
+#include <boost/cstdint.hpp>
+#include <boost/functional/hash.hpp>
 
 #include <osg/Geode>
 #include <osg/Geometry>
 
+#include "common/Trace.hpp"
 #include "common/Utilities.hpp"
 #include "meshing/Face.hpp"
 #include "MarchingCubeConstants.hpp"
 
 
-MarchingCubeMesherCallback::MarchingCubeMesherCallback(const StockDescription& desc) :
+/**
+ * hashes the position of a vertex: marching cubes vertices lie on the
+ * midpoints of the voxels edges, so positions identify the edges. Shared
+ * edges are computed from the same corners, so their midpoints have the
+ * same bits, that are hashed directly.
+ */
+struct VertexHash {
+	std::size_t operator()(const osg::Vec3 &vertex) const {
+		std::size_t seed = 0;
+		for (int i = 0; i < 3; ++i) {
+			float coord = vertex[i];
+			boost::uint32_t bits;
+			std::memcpy(&bits, &coord, sizeof(bits));
+			boost::hash_combine(seed, bits);
+		}
+		
+		return seed;
+	}
+};
+
+/**
+ * @class MarchingCubeMesherCallback::LeafMesh
+ *
+ * geometries built for a leaf: they are kept as user data of the leaf
+ * geode, so that they can be patched when some of its voxels change
+ */
+class MarchingCubeMesherCallback::LeafMesh : public osg::Referenced {
+	
+private:
+	/** initial size of #weldTable */
+	static const std::size_t MIN_WELD_TABLE = 256;
+	
+	/** open addressing hash table of the welded vertices, filled only while
+	 * the geometry is being built: it holds indices of #mcVertices plus one
+	 * (0 if the slot is empty). Vertices are never removed from it, so a flat
+	 * table avoids an allocation per vertex.
+	 */
+	std::vector< unsigned int > weldTable;
+	
+public:
+	/** true if triangles share their vertices */
+	const bool welded;
+	
+	/* MARCHING CUBES geometry */
+	const osg::ref_ptr< osg::Geometry > mcGeom;
+	const osg::ref_ptr< osg::Vec3Array > mcVertices;
+	/** one normal per triangle, or per vertex if #welded */
+	const osg::ref_ptr< osg::Vec3Array > mcNormals;
+	/** draws the triangles unless #welded */
+	const osg::ref_ptr< osg::DrawArrays > mcDrawer;
+	GeometrySlots mcSlots;
+	/** draws the triangles if #welded */
+	const osg::ref_ptr< osg::DrawElementsUInt > mcIndices;
+	
+	/* BOX GEOMETRY */
+	const osg::ref_ptr< osg::Geometry > boxGeom;
+	const osg::ref_ptr< osg::Vec3Array > boxVertices;
+	/** one face type per quad: indexes both colors and normals */
+	const osg::ref_ptr< osg::UByteArray > boxFaces;
+	const osg::ref_ptr< osg::DrawArrays > boxDrawer;
+	GeometrySlots boxSlots;
+	
+	/**
+	 * constructor
+	 *
+	 * @param mcColors color of the marching cubes triangles
+	 * @param boxColors colors of the border faces
+	 * @param boxNormals normals of the border faces
+	 * @param welded true if triangles have to share their vertices
+	 */
+	LeafMesh(osg::Vec4Array *mcColors, osg::Vec4Array *boxColors, osg::Vec3Array *boxNormals,
+			bool welded) :
+		welded(welded),
+		mcGeom(new osg::Geometry), mcVertices(new osg::Vec3Array), mcNormals(new osg::Vec3Array),
+		mcDrawer(new osg::DrawArrays(osg::PrimitiveSet::TRIANGLES, 0, 0)),
+		mcIndices(new osg::DrawElementsUInt(osg::PrimitiveSet::TRIANGLES)),
+		boxGeom(new osg::Geometry), boxVertices(new osg::Vec3Array), boxFaces(new osg::UByteArray),
+		boxDrawer(new osg::DrawArrays(osg::PrimitiveSet::QUADS, 0, 0))
+	{
+		// color (just one)
+		mcGeom->setColorArray(mcColors);
+		mcGeom->setColorBinding(osg::Geometry::BIND_OVERALL);
+		
+		mcGeom->setVertexArray(mcVertices.get());
+		mcGeom->setNormalArray(mcNormals.get());
+		if (welded) {
+			mcGeom->setNormalBinding(osg::Geometry::BIND_PER_VERTEX);
+			mcGeom->addPrimitiveSet(mcIndices.get());
+		} else {
+			mcGeom->setNormalBinding(osg::Geometry::BIND_PER_PRIMITIVE);
+			mcGeom->addPrimitiveSet(mcDrawer.get());
+		}
+		
+		boxGeom->setColorArray(boxColors);
+		boxGeom->setColorIndices(boxFaces.get());
+		boxGeom->setColorBinding(osg::Geometry::BIND_PER_PRIMITIVE);
+		
+		boxGeom->setNormalArray(boxNormals);
+		boxGeom->setNormalIndices(boxFaces.get());
+		boxGeom->setNormalBinding(osg::Geometry::BIND_PER_PRIMITIVE);
+		
+		boxGeom->setVertexArray(boxVertices.get());
+		boxGeom->addPrimitiveSet(boxDrawer.get());
+		
+		// geometries are modified in place, so they can't be drawn while updating
+		mcGeom->setDataVariance(osg::Object::DYNAMIC);
+		boxGeom->setDataVariance(osg::Object::DYNAMIC);
+	}
+	
+	/**
+	 * makes the changes of the primitives visible
+	 */
+	void commit() {
+		if (welded) {
+			mcIndices->dirty();
+		} else {
+			mcDrawer->setCount(mcVertices->size());
+			mcDrawer->dirty();
+		}
+		mcVertices->dirty();
+		mcNormals->dirty();
+		mcGeom->dirtyDisplayList();
+		mcGeom->dirtyBound();
+		
+		boxDrawer->setCount(boxVertices->size());
+		boxDrawer->dirty();
+		boxVertices->dirty();
+		boxFaces->dirty();
+		boxGeom->dirtyDisplayList();
+		boxGeom->dirtyBound();
+	}
+	
+	/**
+	 * appends triangles to the #welded geometry: their vertices are shared
+	 * with the triangles already appended
+	 *
+	 * @param triangles
+	 * @param triangleNormals one per triangle
+	 */
+	void weldTriangles(const std::vector< osg::Vec3 > &triangles,
+			const std::vector< osg::Vec3 > &triangleNormals) {
+		assert(welded);
+		
+		for (unsigned int v = 0; v < triangles.size(); ++v) {
+			unsigned int idx = weldVertex(triangles[v]);
+			
+			// summed here, normalized by #finishWelding
+			(*mcNormals)[idx] += triangleNormals[v / 3];
+			mcIndices->push_back(idx);
+		}
+	}
+	
+	/**
+	 * makes the normals of the #welded vertices the mean of the normals of
+	 * their triangles, and frees the memory used to weld them
+	 */
+	void finishWelding() {
+		osg::Vec3Array::iterator normalIt = mcNormals->begin();
+		for (; normalIt != mcNormals->end(); ++normalIt) {
+			normalIt->normalize();
+		}
+		
+		std::vector< unsigned int >().swap(weldTable);
+	}
+	
+	/**
+	 *
+	 * @return True if the geometries waste so many primitives that they
+	 * should be rebuilt
+	 */
+	bool isFragmented() const {
+		return mcSlots.isFragmented() || boxSlots.isFragmented();
+	}
+	
+protected:
+	virtual ~LeafMesh() { }
+	
+private:
+	/**
+	 * 
+	 * @param vertex
+	 * @return the index of the given vertex, that is appended to the
+	 * #welded geometry if new
+	 */
+	unsigned int weldVertex(const osg::Vec3 &vertex) {
+		// the table is kept at most half full
+		if (weldTable.size() < (mcVertices->size() + 1) * 2) {
+			growWeldTable();
+		}
+		
+		const std::size_t mask = weldTable.size() - 1;
+		std::size_t slot = VertexHash()(vertex) & mask;
+		for (; weldTable[slot] != 0; slot = (slot + 1) & mask) {
+			if ((*mcVertices)[weldTable[slot] - 1] == vertex) {
+				return weldTable[slot] - 1;
+			}
+		}
+		
+		mcVertices->push_back(vertex);
+		mcNormals->push_back(osg::Vec3(0, 0, 0));
+		weldTable[slot] = mcVertices->size();
+		
+		return weldTable[slot] - 1;
+	}
+	
+	/**
+	 * doubles the size of #weldTable
+	 */
+	void growWeldTable() {
+		std::vector< unsigned int > table(std::max(weldTable.size() * 2, MIN_WELD_TABLE), 0);
+		
+		const std::size_t mask = table.size() - 1;
+		for (unsigned int v = 0; v < mcVertices->size(); ++v) {
+			std::size_t slot = VertexHash()((*mcVertices)[v]) & mask;
+			while (table[slot] != 0) {
+				slot = (slot + 1) & mask;
+			}
+			table[slot] = v + 1;
+		}
+		
+		weldTable.swap(table);
+	}
+};
+
+const std::size_t MarchingCubeMesherCallback::LeafMesh::MIN_WELD_TABLE;
+
+/**
+ * @struct MarchingCubeMesherCallback::VoxelPrimitives
+ *
+ * primitives of the voxel being meshed: every build or patch uses its own
+ * buffers, so that leaves can be meshed by many threads
+ */
+struct MarchingCubeMesherCallback::VoxelPrimitives {
+	
+	/** used to calculate the normals */
+	Eigen::Vector3d edgeVertices[12];
+	
+	/** marching cubes triangles */
+	std::vector< osg::Vec3 > triangles;
+	/** normals of #triangles */
+	std::vector< osg::Vec3 > triangleNormals;
+	/** border faces */
+	std::vector< osg::Vec3 > quads;
+	/** types (Face::Type) of #quads */
+	std::vector< unsigned char > quadFaces;
+	
+	/**
+	 * empties the buffers, keeping their memory
+	 */
+	void clear() {
+		triangles.clear();
+		triangleNormals.clear();
+		quads.clear();
+		quadFaces.clear();
+	}
+};
+
+/**
+ * collapses some primitives on their first vertex, so that they are not
+ * rasterized and don't change the geometry bounds
+ *
+ * @param vertices vertex array of the geometry
+ * @param verticesPerPrimitive
+ * @param range the primitives
+ */
+static void collapsePrimitives(osg::Vec3Array &vertices, unsigned int verticesPerPrimitive,
+		const GeometrySlots::Range &range) {
+	
+	for (unsigned int p = range.first; p < range.first + range.count; ++p) {
+		unsigned int firstVertex = p * verticesPerPrimitive;
+		for (unsigned int v = 1; v < verticesPerPrimitive; ++v) {
+			vertices[firstVertex + v] = vertices[firstVertex];
+		}
+	}
+}
+
+/**
+ * replaces the primitives owned by an element of a geometry with new ones:
+ * they are overwritten in place if the new ones fit, otherwise they are
+ * released and the new ones are allocated elsewhere
+ *
+ * @param slots primitives ownership
+ * @param key the element
+ * @param replace false if the element owns no primitive, and the new ones
+ * can be appended to the geometry
+ * @param verticesPerPrimitive
+ * @param newVertices vertices of the new primitives
+ * @param newAttributes per primitive attributes of the new primitives
+ * @param vertices vertex array of the geometry
+ * @param attributes per primitive attributes array of the geometry
+ */
+template < class AttributeArray >
+static void replacePrimitives(GeometrySlots &slots, GeometrySlots::Key key, bool replace,
+		unsigned int verticesPerPrimitive, const std::vector< osg::Vec3 > &newVertices,
+		const std::vector< typename AttributeArray::value_type > &newAttributes,
+		osg::Vec3Array &vertices, AttributeArray &attributes) {
+	
+	assert(newVertices.size() == newAttributes.size() * verticesPerPrimitive);
+	unsigned int nPrimitives = newAttributes.size();
+	
+	GeometrySlots::Range range;
+	if (replace && slots.find(key, range)) {
+		if (nPrimitives > 0 && nPrimitives <= range.count) {
+			std::copy(newVertices.begin(), newVertices.end(),
+					vertices.begin() + range.first * verticesPerPrimitive);
+			std::copy(newAttributes.begin(), newAttributes.end(),
+					attributes.begin() + range.first);
+			
+			collapsePrimitives(vertices, verticesPerPrimitive,
+					GeometrySlots::Range(range.first + nPrimitives, range.count - nPrimitives));
+			return;
+		}
+		
+		slots.release(key, range);
+		collapsePrimitives(vertices, verticesPerPrimitive, range);
+	}
+	
+	if (nPrimitives == 0) {
+		return;
+	}
+	
+	if (replace) {
+		range = slots.allocate(key, nPrimitives);
+	} else {
+		range = slots.append(key, nPrimitives);
+	}
+	
+	if (attributes.size() < slots.getSize()) {
+		vertices.resize(slots.getSize() * verticesPerPrimitive);
+		attributes.resize(slots.getSize());
+	}
+	
+	std::copy(newVertices.begin(), newVertices.end(),
+			vertices.begin() + range.first * verticesPerPrimitive);
+	std::copy(newAttributes.begin(), newAttributes.end(),
+			attributes.begin() + range.first);
+}
+
+MarchingCubeMesherCallback::MarchingCubeMesherCallback(const StockDescription& desc, bool weldVertices) :
 		mcColorArray(new osg::Vec4Array(1)), boxColorArray(new osg::Vec4Array(Face::N_FACES)), 
-		boxNormals(new osg::Vec3Array(Face::N_FACES)), STOCK_HALF_EXTENTS(desc.getGeometry()->asEigen() * 0.5)
+		boxNormals(new osg::Vec3Array(Face::N_FACES)), STOCK_HALF_EXTENTS(desc.getGeometry()->asEigen() * 0.5),
+		WELD_VERTICES(weldVertices)
 {
 	assert(Corner::N_CORNERS == 8); // this class is full of bitwise operations that needs it
 	// another assertion is that a box has 12edges...
@@ -47,134 +393,19 @@ MarchingCubeMesherCallback::~MarchingCubeMesherCallback() {
 osg::ref_ptr<osg::Node> MarchingCubeMesherCallback::buildNode(const LeafNodeData& data) {
 	assert(data.isDirty() && !data.isEmpty());
 	
-	/* MARCHING CUBES geometry */
-	osg::Geometry *mcGeom = new osg::Geometry;
-	
-	// color (just one)
-	mcGeom->setColorArray(mcColorArray.get());
-	mcGeom->setColorBinding(osg::Geometry::BIND_OVERALL);
-	
-	// vertices array
-	osg::Vec3Array *mcVertices = new osg::Vec3Array;
-	mcGeom->setVertexArray(mcVertices);
-	
-	// normals array
-	osg::Vec3Array *mcNormals = new osg::Vec3Array;
-	mcGeom->setNormalArray(mcNormals);
-	mcGeom->setNormalBinding(osg::Geometry::BIND_PER_PRIMITIVE);
-	
-	/* BOX GEOMETRY */
-	osg::ref_ptr< osg::Geometry > boxGeom = new osg::Geometry;
-	
-	boxGeom->setColorArray(boxColorArray.get());
-	osg::UByteArray *boxColorIndices = new osg::UByteArray;
-	boxGeom->setColorIndices(boxColorIndices);
-	boxGeom->setColorBinding(osg::Geometry::BIND_PER_PRIMITIVE);
-	
-	boxGeom->setNormalArray(boxNormals.get());
-	osg::UByteArray *boxNormalsIndices = new osg::UByteArray;
-	boxGeom->setNormalIndices(boxNormalsIndices);
-	boxGeom->setNormalBinding(osg::Geometry::BIND_PER_PRIMITIVE);
-	
-	osg::Vec3Array *boxVertices = new osg::Vec3Array;
-	boxGeom->setVertexArray(boxVertices);
-	
-	/* DATA ANALYSIS */
+	osg::ref_ptr< LeafMesh > mesh = new LeafMesh(mcColorArray.get(),
+			boxColorArray.get(), boxNormals.get(), WELD_VERTICES);
 	
 	/* build vertices, normals and facets */
+	VoxelPrimitives prims;
 	GraphicData::List::const_iterator dataIt = data.getElements().begin();
 	for(; dataIt != data.getElements().end(); ++dataIt) {
-		
-		if (dataIt->vinfo->isIntersecting()) {
-			/* Given data must be processed with marching cubes */
-			
-			/* marching cube meshing algorithm adapted from
-			 * http://paulbourke.net/geometry/polygonise/
-			 */
-			
-			/*
-			  Given a grid Cell and an isolevel, calculate the triangular
-			  facets required to represent the isosurface through the Cell.
-			  The array "vertices" will be loaded up with the vertices of at most
-			  5 triangular facets. Nothing will be added if the grid Cell is
-			  either totally above or totally below the cutterThreshold.
-			*/
-			
-			MeshingVoxel gridCell(dataIt->sbox.get(), dataIt->vinfo.get(), STOCK_HALF_EXTENTS);
-			
-			/* Determine the index into the edge table which
-			 * tells us which vertices are inside of the surface
-			 */
-			int cubeindex = 0x00;
-			for (int i = 0; i < Corner::N_CORNERS; ++i) {
-				cubeindex |= ((int)(gridCell.getWeight(i) < MC_THRESHOLD_LEVEL)) << i;
-			}
-	
-			/* Cube is entirely in/out of the surface */
-			if (MarchingCubeMesherCallback::edgeTable[cubeindex] == 0) {
-				continue;
-			}
-			
-			/* Find the edges where the surface intersects the cube and push back
-			 * appropriate vertices
-			 */
-			int edgeMask = MarchingCubeMesherCallback::edgeTable[cubeindex];
-			for (int i = 0; i < 12; ++i) {
-				if (edgeMask & (0x01 << i)) {
-					tmpVertices[i] = vertInterp(gridCell, i);
-				}
-			}
-			
-			/* Create all needed triangle facets */
-			for (int i = 0; MarchingCubeMesherCallback::triTable[cubeindex][i] != -1; i += 3) {
-				unsigned int firstIdx = MarchingCubeMesherCallback::triTable[cubeindex][i],
-						secondIdx = MarchingCubeMesherCallback::triTable[cubeindex][i+1],
-						thirdIdx = MarchingCubeMesherCallback::triTable[cubeindex][i+2];
-				
-				assert(MarchingCubeMesherCallback::triTable[cubeindex][i] != -1 && 
-						MarchingCubeMesherCallback::triTable[cubeindex][i+1] != -1 &&
-						MarchingCubeMesherCallback::triTable[cubeindex][i+2] != -1);
-				
-				mcVertices->push_back(GeometryUtils::toOsg(tmpVertices[firstIdx]));
-				mcVertices->push_back(GeometryUtils::toOsg(tmpVertices[secondIdx]));
-				mcVertices->push_back(GeometryUtils::toOsg(tmpVertices[thirdIdx]));
-				
-				// a new face has been added, now calculate its normal
-				Eigen::Vector3d norm; norm.noalias() = 
-						(tmpVertices[secondIdx] - tmpVertices[firstIdx]) // first vector
-							.cross
-						(tmpVertices[thirdIdx] - tmpVertices[firstIdx]) // second vector
-							.normalized();
-				
-				mcNormals->push_back(GeometryUtils::toOsg(norm));
-			}
-			
-		} else {
-			/* given data must be processed as a border voxel */
-			
-			FaceIterator fit = FaceIterator::begin();
-			for (; fit != FaceIterator::end(); ++fit) {
-				
-				if (! Face::isBorderFace(*fit, STOCK_HALF_EXTENTS, *dataIt->sbox)) {
-					continue;
-				}
-				
-				// build current face
-				for (int i = 0; i < 4; ++i) {
-					boxVertices->push_back(
-						GeometryUtils::toOsg(
-							dataIt->sbox->getCorner(Face::FACE_ADJACENCY[*fit][i])
-						)
-					);
-				}
-				
-				// add proper normal & color
-				boxNormalsIndices->push_back(*fit);
-				boxColorIndices->push_back(*fit);
-			}
-			
-		}
+		meshElement(*mesh, *dataIt, false, prims);
 	}
+	if (WELD_VERTICES) {
+		mesh->finishWelding();
+	}
+	mesh->commit();
 	
 	/* CREATING GEODE */
 	
@@ -190,33 +421,166 @@ osg::ref_ptr<osg::Node> MarchingCubeMesherCallback::buildNode(const LeafNodeData
 	 * loro versione indicizzata da u_int occuperebbe 31.039mu (dove 1mu
 	 * -memory unit- corrisponde allo spazio occupato da un float ovvero lo
 	 * spazio occupato da un GL_INT ovvero 4byte)
+	 * However across a whole leaf the same vertex is shared by the triangles
+	 * of many voxels, so welded leaves (see WELD_VERTICES) are indexed.
 	 */
-	assert(mcVertices->size() % 3 == 0);
-	osg::DrawArrays *triangleDrawer = new osg::DrawArrays(
-			osg::PrimitiveSet::TRIANGLES,
-			0,
-			mcVertices->size()
-	);
-	mcGeom->addPrimitiveSet(triangleDrawer);
-	geode->addDrawable(mcGeom);
-	
-	
-	if (!boxVertices->empty()) {
-		assert(boxVertices->size() % 4 == 0);
-		osg::DrawArrays *boxDrawer = new osg::DrawArrays(
-				osg::PrimitiveSet::QUADS,
-				0,
-				boxVertices->size()
-		);
-		boxGeom->addPrimitiveSet(boxDrawer);
-		geode->addDrawable(boxGeom.get());
-	}
+	geode->addDrawable(mesh->mcGeom.get());
+	geode->addDrawable(mesh->boxGeom.get());
+	geode->setUserData(mesh.get());
 	
 	return geode.get();
 }
 
+bool MarchingCubeMesherCallback::patchNode(osg::Node* node, const LeafNodeData& data) {
+	assert(data.isDirty() && !data.isEmpty());
+	
+	/* welded vertices and their normals are shared with the triangles of
+	 * the neighbour voxels, so welded leaves are always rebuilt
+	 */
+	LeafMesh *mesh = dynamic_cast< LeafMesh * >(node->getUserData());
+	if (mesh == NULL || mesh->welded || mesh->isFragmented()) {
+		return false;
+	}
+	
+	Trace::Scope scope("leaf geometry patch", "visualization");
+	
+	// deletions first: their addresses may have been reused by changed elements
+	VoxelPrimitives prims;
+	
+	LeafNodeData::ElmSet::const_iterator elmIt = data.getRemovedElms().begin();
+	for (; elmIt != data.getRemovedElms().end(); ++elmIt) {
+		replacePrimitives(mesh->mcSlots, *elmIt, true, 3, prims.triangles, prims.triangleNormals,
+				*mesh->mcVertices, *mesh->mcNormals);
+		replacePrimitives(mesh->boxSlots, *elmIt, true, 4, prims.quads, prims.quadFaces,
+				*mesh->boxVertices, *mesh->boxFaces);
+	}
+	
+	elmIt = data.getChangedElms().begin();
+	for (; elmIt != data.getChangedElms().end(); ++elmIt) {
+		meshElement(*mesh, **elmIt, true, prims);
+	}
+	
+	return true;
+}
+
+void MarchingCubeMesherCallback::commitNode(osg::Node* node) {
+	LeafMesh *mesh = dynamic_cast< LeafMesh * >(node->getUserData());
+	assert(mesh != NULL);
+	
+	mesh->commit();
+}
+
+void MarchingCubeMesherCallback::meshElement(LeafMesh& mesh, const GraphicData& elm,
+		bool replace, VoxelPrimitives &prims) const {
+	prims.clear();
+	
+	if (elm.isIntersecting()) {
+		/* Given data must be processed with marching cubes */
+		buildTriangles(elm, prims);
+	} else {
+		/* given data must be processed as a border voxel */
+		buildBorderFaces(elm, prims);
+	}
+	
+	if (mesh.welded) {
+		assert(!replace);
+		mesh.weldTriangles(prims.triangles, prims.triangleNormals);
+	} else {
+		replacePrimitives(mesh.mcSlots, &elm, replace, 3, prims.triangles, prims.triangleNormals,
+				*mesh.mcVertices, *mesh.mcNormals);
+	}
+	replacePrimitives(mesh.boxSlots, &elm, replace, 4, prims.quads, prims.quadFaces,
+			*mesh.boxVertices, *mesh.boxFaces);
+}
+
+void MarchingCubeMesherCallback::buildTriangles(const GraphicData& elm, VoxelPrimitives &prims) const {
+	
+	/* marching cube meshing algorithm adapted from
+	 * http://paulbourke.net/geometry/polygonise/
+	 */
+	
+	/*
+	  Given a grid Cell and an isolevel, calculate the triangular
+	  facets required to represent the isosurface through the Cell.
+	  The array "vertices" will be loaded up with the vertices of at most
+	  5 triangular facets. Nothing will be added if the grid Cell is
+	  either totally above or totally below the cutterThreshold.
+	*/
+	
+	MeshingVoxel gridCell(elm.sbox.get(), elm, STOCK_HALF_EXTENTS);
+	
+	/* Determine the index into the edge table which
+	 * tells us which vertices are inside of the surface
+	 */
+	int cubeindex = 0x00;
+	for (int i = 0; i < Corner::N_CORNERS; ++i) {
+		cubeindex |= ((int)(gridCell.getWeight(i) < MC_THRESHOLD_LEVEL)) << i;
+	}
+
+	/* Cube is entirely in/out of the surface */
+	if (MarchingCubeMesherCallback::edgeTable[cubeindex] == 0) {
+		return;
+	}
+	
+	/* Find the edges where the surface intersects the cube and push back
+	 * appropriate vertices
+	 */
+	int edgeMask = MarchingCubeMesherCallback::edgeTable[cubeindex];
+	for (int i = 0; i < 12; ++i) {
+		if (edgeMask & (0x01 << i)) {
+			prims.edgeVertices[i] = vertInterp(gridCell, i);
+		}
+	}
+	
+	/* Create all needed triangle facets */
+	for (int i = 0; MarchingCubeMesherCallback::triTable[cubeindex][i] != -1; i += 3) {
+		unsigned int firstIdx = MarchingCubeMesherCallback::triTable[cubeindex][i],
+				secondIdx = MarchingCubeMesherCallback::triTable[cubeindex][i+1],
+				thirdIdx = MarchingCubeMesherCallback::triTable[cubeindex][i+2];
+		
+		assert(MarchingCubeMesherCallback::triTable[cubeindex][i] != -1 && 
+				MarchingCubeMesherCallback::triTable[cubeindex][i+1] != -1 &&
+				MarchingCubeMesherCallback::triTable[cubeindex][i+2] != -1);
+		
+		prims.triangles.push_back(GeometryUtils::toOsg(prims.edgeVertices[firstIdx]));
+		prims.triangles.push_back(GeometryUtils::toOsg(prims.edgeVertices[secondIdx]));
+		prims.triangles.push_back(GeometryUtils::toOsg(prims.edgeVertices[thirdIdx]));
+		
+		// a new face has been added, now calculate its normal
+		Eigen::Vector3d norm; norm.noalias() = 
+				(prims.edgeVertices[secondIdx] - prims.edgeVertices[firstIdx]) // first vector
+					.cross
+				(prims.edgeVertices[thirdIdx] - prims.edgeVertices[firstIdx]) // second vector
+					.normalized();
+		
+		prims.triangleNormals.push_back(GeometryUtils::toOsg(norm));
+	}
+}
+
+void MarchingCubeMesherCallback::buildBorderFaces(const GraphicData& elm, VoxelPrimitives &prims) const {
+	
+	FaceIterator fit = FaceIterator::begin();
+	for (; fit != FaceIterator::end(); ++fit) {
+		
+		if (! Face::isBorderFace(*fit, STOCK_HALF_EXTENTS, *elm.sbox)) {
+			continue;
+		}
+		
+		// build current face
+		for (int i = 0; i < 4; ++i) {
+			prims.quads.push_back(
+				GeometryUtils::toOsg(
+					elm.sbox->getCorner(Face::FACE_ADJACENCY[*fit][i])
+				)
+			);
+		}
+		
+		// add proper normal & color
+		prims.quadFaces.push_back(*fit);
+	}
+}
 
-Eigen::Vector3d MarchingCubeMesherCallback::vertInterp(const MeshingVoxel& grid, int edgeIdx) {
+Eigen::Vector3d MarchingCubeMesherCallback::vertInterp(const MeshingVoxel& grid, int edgeIdx) const {
 	
 	int p1idx = MarchingCubeMesherCallback::cornerAdjTable[edgeIdx][0],
 			p2idx = MarchingCubeMesherCallback::cornerAdjTable[edgeIdx][1];
@@ -17,12 +17,14 @@
 #include "meshing/LeafNodeCallback.hpp"
 
 #include <cassert>
+#include <vector>
 
 #include <Eigen/Geometry>
 
 #include <osg/Array>
 
 #include "configuration/StockDescription.hpp"
+#include "meshing/GeometrySlots.hpp"
 #include "MeshingVoxel.hpp"
 
 /**
@@ -30,10 +32,20 @@
  *
  * Marching Cubes algorithm is implemented here.
  * Tables are borrowed from http://paulbourke.net/geometry/polygonise/ (many thanks)
+ *
+ * Every voxel owns a range of the primitives of the geometries of its leaf,
+ * so that when a few voxels change only their primitives are rewritten.
+ * Optionally the triangles of a leaf share their vertices, which get
+ * smooth normals: such leaves use less memory but are always rebuilt.
+ * Leaves can be meshed concurrently: no state is shared between calls.
  */
 class MarchingCubeMesherCallback : public LeafNodeCallback {
 	
 private:
+	class LeafMesh;
+	struct VoxelPrimitives;
+	
+
 	/** contains the possible combinations of triangle faces */
 	static const int edgeTable[256];
 	/** for every possible combination of triangle faces, indicates the vertices and edges involved in its construction */
@@ -55,16 +67,18 @@ private:
 	/** distances from the center of the stock block to the faces */
 	const Eigen::Vector3d STOCK_HALF_EXTENTS;
 	
-	/** used to calculate the normals */
-	Eigen::Vector3d tmpVertices[12];
+	/** if true the vertices of the triangles of a leaf are welded */
+	const bool WELD_VERTICES;
 	
 public:
 	/**
 	 * constructor
 	 *
 	 * @param desc : the stock characteristics
+	 * @param weldVertices : if true the triangles of a leaf are indexed and
+	 * share their vertices, with per vertex normals
 	 */
-	MarchingCubeMesherCallback(const StockDescription &desc);
+	MarchingCubeMesherCallback(const StockDescription &desc, bool weldVertices = false);
 	
 	/**
 	 * MC algo.
@@ -75,6 +89,23 @@ public:
 	 */
 	virtual osg::ref_ptr< osg::Node > buildNode(const LeafNodeData &data);
 	
+	/**
+	 * rewrites only the primitives of the voxels changed since the node
+	 * was built
+	 *
+	 * @param node the node built for the data
+	 * @param data
+	 * @return false if the node has to be rebuilt
+	 */
+	virtual bool patchNode(osg::Node *node, const LeafNodeData &data);
+	
+	/**
+	 * makes the primitives rewritten by #patchNode visible
+	 *
+	 * @param node
+	 */
+	virtual void commitNode(osg::Node *node);
+	
 protected:
 	/**
 	 * destructor - empty
@@ -83,6 +114,35 @@ protected:
 	
 private:
 	
+	/**
+	 * replaces the primitives of a voxel with new ones
+	 *
+	 * @param mesh the geometries of the leaf of the voxel
+	 * @param elm the voxel
+	 * @param replace false if the voxel has no primitive yet
+	 * @param prims buffers used to build the new primitives
+	 */
+	void meshElement(LeafMesh &mesh, const GraphicData &elm, bool replace,
+			VoxelPrimitives &prims) const;
+	
+	/**
+	 * fills the triangles of the given buffers with the marching cubes
+	 * triangles of a voxel
+	 *
+	 * @param elm an intersecting voxel
+	 * @param prims
+	 */
+	void buildTriangles(const GraphicData &elm, VoxelPrimitives &prims) const;
+	
+	/**
+	 * fills the quads of the given buffers with the faces of a voxel that
+	 * lie on the stock border
+	 *
+	 * @param elm a non intersecting voxel
+	 * @param prims
+	 */
+	void buildBorderFaces(const GraphicData &elm, VoxelPrimitives &prims) const;
+	
 	/**
 	 * calculates the midpoint of an edge
 	 *
@@ -90,7 +150,7 @@ private:
 	 * @param edgeIdx : the edge of the voxel where the midpoint lies
 	 * @return the coords of the midpoint
 	 */
-	Eigen::Vector3d vertInterp(const MeshingVoxel &grid, int edgeIdx);
+	Eigen::Vector3d vertInterp(const MeshingVoxel &grid, int edgeIdx) const;
 	
 };
 
@@ -17,7 +17,7 @@
 #include "common/Utilities.hpp"
 #include "milling/Corner.hpp"
 #include "milling/ShiftedBox.hpp"
-#include "milling/VoxelInfo.hpp"
+#include "milling/graphics_info.hpp"
 #include "meshing/MeshingUtils.hpp"
 
 /**
@@ -52,9 +52,9 @@ public:
 	 * this class would have been created
 	 *  
 	 * @param sbox
-	 * @param vinfo
+	 * @param data voxel corners snapshot
 	 */
-	MeshingVoxel(const ShiftedBox *sbox, const VoxelInfo *vinfo, const Eigen::Vector3d &stockHalfExtents) :
+	MeshingVoxel(const ShiftedBox *sbox, const GraphicData &data, const Eigen::Vector3d &stockHalfExtents) :
 		sbox(sbox)
 	{
 		/* this assert is due to the static '8' used to initialize
@@ -74,7 +74,7 @@ public:
 			Corner::CornerType c = CORNER_CONVERSION[i];
 			char value;
 			
-			if (vinfo->isCornerCut(c)) {
+			if (data.isCornerCut(c)) {
 				value = +1;
 			} else {
 				Eigen::Vector3d corner(sbox->getCorner(CORNER_CONVERSION[i]));
@@ -0,0 +1,658 @@
+/**
+ * @file microbench.cpp
+ *
+ * microbenchmarks of the milling and meshing kernels: every kernel is run
+ * in isolation on inputs built from the moves of a positions file, so that
+ * optimizations of a single kernel can be measured without the noise of
+ * the whole simulation
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/chrono.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/program_options.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_real_distribution.hpp>
+
+#include <Eigen/Geometry>
+
+#include <osg/Node>
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/Group>
+
+#include "common/constants.hpp"
+#include "configuration/ConfigFileParser.hpp"
+#include "configuration/Geometry.hpp"
+#include "milling/Corner.hpp"
+#include "milling/Cutter.hpp"
+#include "milling/cutters.hpp"
+#include "milling/MillingAlgorithm.hpp"
+#include "milling/Octree.hpp"
+#include "milling/ShiftedBox.hpp"
+#include "milling/Stock.hpp"
+#include "milling/StoredData.hpp"
+#include "meshing/LeafNodeData.hpp"
+#include "meshing/Mesher.hpp"
+#include "meshing/mesherCallbacks/MarchingCubeMesherCallback.hpp"
+
+using namespace std;
+
+namespace bpo = boost::program_options;
+
+/**
+ * @class BenchState
+ *
+ * iterations a kernel has to perform and time it took: kernels may exclude
+ * their setup from the measure pausing the timer
+ */
+class BenchState {
+
+public:
+	typedef boost::chrono::steady_clock Clock;
+
+private:
+	const unsigned long ITERATIONS;
+	Clock::duration elapsed;
+	Clock::time_point start;
+
+public:
+	BenchState(unsigned long iterations) :
+		ITERATIONS(iterations), elapsed(Clock::duration::zero()) { }
+
+	unsigned long getIterations() const {
+		return ITERATIONS;
+	}
+
+	void resumeTiming() {
+		start = Clock::now();
+	}
+
+	void pauseTiming() {
+		elapsed += Clock::now() - start;
+	}
+
+	Clock::duration getElapsed() const {
+		return elapsed;
+	}
+};
+
+/**
+ * inputs shared by all the kernels, each item is related to a move
+ */
+struct BenchInput {
+	typedef std::vector< ShiftedBox::MinMaxMatrix,
+			Eigen::aligned_allocator< ShiftedBox::MinMaxMatrix > > MinMaxList;
+
+	/** cutter bounding box: extents and pose in model basis */
+	Eigen::Vector3d bboxExtents;
+	Stock::PoseList bboxIsoms_model;
+	/** axis aligned bounding box of the cutter, in model basis */
+	MinMaxList bboxMinMaxs;
+
+	/** a leaf box near the cutter (intersecting it or not) */
+	MinMaxList leaves;
+	/** corners of #leaves, in cutter basis */
+	std::vector< CornerCoords > corners;
+	std::vector< Eigen::Vector3d > points;
+
+	Eigen::Vector3d stockExtents;
+	Cutter::Ptr sphere, cylinder;
+
+	/** chunks of the voxels of the milled stock, as stored by the mesher */
+	std::vector< osg::ref_ptr< LeafNodeData > > meshLeaves;
+	osg::ref_ptr< MarchingCubeMesherCallback > mcCallback;
+	/** same as #mcCallback, but welding the vertices */
+	osg::ref_ptr< MarchingCubeMesherCallback > mcWeldedCallback;
+};
+
+typedef void (*Kernel)(BenchState &, const BenchInput &);
+
+/**
+ * benchmark entry
+ */
+struct Benchmark {
+	const char *name;
+	Kernel kernel;
+};
+
+/** kernels results are accumulated here, so that they cannot be optimized out */
+static volatile double sink;
+
+/**
+ * @class CapturingMesher
+ *
+ * keeps the voxels passed by the stock instead of meshing them
+ */
+class CapturingMesher : public Mesher< StoredData > {
+public:
+	StoredData::VoxelDataPtr voxels;
+
+	virtual Mesh::Ptr buildMesh(const StoredData &data) {
+		if (!data.getData()->empty()) {
+			voxels = data.getData();
+		}
+
+		return boost::make_shared< Mesh >(new osg::Group);
+	}
+};
+
+/*** KERNELS ***/
+
+static void benchSAT(BenchState &state, const BenchInput &in, bool accurate) {
+	const std::size_t n = in.leaves.size();
+	unsigned long hits = 0;
+
+	// boxes are built outside the timed loop
+	state.pauseTiming();
+	std::vector< ShiftedBox *> boxes;
+	for (std::size_t i = 0; i < n; ++i) {
+		boxes.push_back(new ShiftedBox(in.leaves[i]));
+	}
+	state.resumeTiming();
+
+	for (unsigned long it = 0; it < state.getIterations(); ++it) {
+		std::size_t i = it % n;
+		hits += boxes[i]->isIntersecting(in.bboxExtents, in.bboxIsoms_model[i], accurate);
+	}
+
+	state.pauseTiming();
+	for (std::size_t i = 0; i < n; ++i) {
+		delete boxes[i];
+	}
+	state.resumeTiming();
+
+	sink += hits;
+}
+
+static void benchFastSAT(BenchState &state, const BenchInput &in) {
+	benchSAT(state, in, false);
+}
+
+static void benchAccurateSAT(BenchState &state, const BenchInput &in) {
+	benchSAT(state, in, true);
+}
+
+static void benchTableSAT(BenchState &state, const BenchInput &in, bool accurate) {
+	const std::size_t n = in.leaves.size();
+	unsigned long hits = 0;
+
+	// radii are projected once per pose and depth by the stock
+	state.pauseTiming();
+	std::vector< ShiftedBox *> boxes;
+	std::vector< ShiftedBox::SeparatingRadii > radii(n);
+	for (std::size_t i = 0; i < n; ++i) {
+		boxes.push_back(new ShiftedBox(in.leaves[i]));
+		ShiftedBox::calculateSeparatingRadii(boxes[i]->getExtents(), in.bboxExtents,
+				in.bboxIsoms_model[i].linear(), radii[i]);
+	}
+	state.resumeTiming();
+
+	for (unsigned long it = 0; it < state.getIterations(); ++it) {
+		std::size_t i = it % n;
+		hits += boxes[i]->isIntersecting(in.bboxIsoms_model[i], radii[i], accurate);
+	}
+
+	state.pauseTiming();
+	for (std::size_t i = 0; i < n; ++i) {
+		delete boxes[i];
+	}
+	state.resumeTiming();
+
+	sink += hits;
+}
+
+static void benchFastTableSAT(BenchState &state, const BenchInput &in) {
+	benchTableSAT(state, in, false);
+}
+
+static void benchAccurateTableSAT(BenchState &state, const BenchInput &in) {
+	benchTableSAT(state, in, true);
+}
+
+static void benchAABB(BenchState &state, const BenchInput &in) {
+	const std::size_t n = in.leaves.size();
+	unsigned long hits = 0;
+
+	state.pauseTiming();
+	std::vector< ShiftedBox *> boxes;
+	for (std::size_t i = 0; i < n; ++i) {
+		boxes.push_back(new ShiftedBox(in.leaves[i]));
+	}
+	state.resumeTiming();
+
+	for (unsigned long it = 0; it < state.getIterations(); ++it) {
+		std::size_t i = it % n;
+		hits += boxes[i]->isIntersecting(in.bboxMinMaxs[i]);
+	}
+
+	state.pauseTiming();
+	for (std::size_t i = 0; i < n; ++i) {
+		delete boxes[i];
+	}
+	state.resumeTiming();
+
+	sink += hits;
+}
+
+static void benchDistance(BenchState &state, const Cutter &cutter, const BenchInput &in) {
+	const std::size_t n = in.points.size();
+	double acc = 0;
+
+	for (unsigned long it = 0; it < state.getIterations(); ++it) {
+		acc += cutter.getDistance(in.points[it % n]);
+	}
+
+	sink += acc;
+}
+
+static void benchSphereDistance(BenchState &state, const BenchInput &in) {
+	benchDistance(state, *in.sphere, in);
+}
+
+static void benchCylinderDistance(BenchState &state, const BenchInput &in) {
+	benchDistance(state, *in.cylinder, in);
+}
+
+static void benchInsideCorners(BenchState &state, const Cutter &cutter, const BenchInput &in) {
+	const std::size_t n = in.corners.size();
+	unsigned long acc = 0;
+
+	for (unsigned long it = 0; it < state.getIterations(); ++it) {
+		acc += cutter.getInsideCorners(in.corners[it % n]);
+	}
+
+	sink += acc;
+}
+
+static void benchSphereInsideCorners(BenchState &state, const BenchInput &in) {
+	benchInsideCorners(state, *in.sphere, in);
+}
+
+static void benchCylinderInsideCorners(BenchState &state, const BenchInput &in) {
+	benchInsideCorners(state, *in.cylinder, in);
+}
+
+static void benchPushLeaf(BenchState &state, const BenchInput &in) {
+	// trees are rebuilt from scratch every PUSHES_PER_TREE pushes
+	static const unsigned long PUSHES_PER_TREE = 1 << 16;
+	Octree::VersionInfo vinfo(1, 2);
+
+	unsigned long pushed = 0;
+	while (pushed < state.getIterations()) {
+		state.pauseTiming();
+		Octree *tree = new Octree(in.stockExtents);
+		std::deque< Octree::LeafPtr > leaves;
+		for (int i = 0; i < BranchNode::N_CHILDREN; ++i) {
+			leaves.push_back(static_cast< Octree::LeafPtr >(tree->getRoot()->getChild(i)));
+		}
+		state.resumeTiming();
+
+		// breadth first, as the miller does while descending the stock
+		for (unsigned long p = 0; p < PUSHES_PER_TREE && pushed < state.getIterations(); ++p, ++pushed) {
+			Octree::BranchPtr branch = tree->pushLeaf(leaves.front(), vinfo);
+			leaves.pop_front();
+
+			for (int i = 0; i < BranchNode::N_CHILDREN; ++i) {
+				leaves.push_back(static_cast< Octree::LeafPtr >(branch->getChild(i)));
+			}
+		}
+
+		state.pauseTiming();
+		sink += leaves.size();
+		delete tree;
+		state.resumeTiming();
+	}
+}
+
+static void benchMarchingCubeBuildNode(BenchState &state, const BenchInput &in) {
+	const std::size_t n = in.meshLeaves.size();
+	unsigned long built = 0;
+
+	for (unsigned long it = 0; it < state.getIterations(); ++it) {
+		osg::ref_ptr< osg::Node > node = in.mcCallback->buildNode(*in.meshLeaves[it % n]);
+		built += node.valid();
+	}
+
+	sink += built;
+}
+
+static void benchMarchingCubeWeldedBuildNode(BenchState &state, const BenchInput &in) {
+	const std::size_t n = in.meshLeaves.size();
+	unsigned long built = 0;
+
+	for (unsigned long it = 0; it < state.getIterations(); ++it) {
+		osg::ref_ptr< osg::Node > node = in.mcWeldedCallback->buildNode(*in.meshLeaves[it % n]);
+		built += node.valid();
+	}
+
+	sink += built;
+}
+
+static void benchMarchingCubePatchNode(BenchState &state, const BenchInput &in) {
+	// a voxel every CHANGE_STRIDE is changed before each patch
+	static const unsigned int CHANGE_STRIDE = 10;
+
+	state.pauseTiming();
+	std::vector< osg::ref_ptr< LeafNodeData > > leaves;
+	std::vector< osg::ref_ptr< osg::Node > > nodes;
+	for (std::size_t l = 0; l < in.meshLeaves.size(); ++l) {
+		osg::ref_ptr< LeafNodeData > leaf = new LeafNodeData(in.meshLeaves[l]->getCompetenceBox(), 0);
+		GraphicData::List::const_iterator elmIt = in.meshLeaves[l]->getElements().begin();
+		for (; elmIt != in.meshLeaves[l]->getElements().end(); ++elmIt) {
+			leaf->insertElm(*elmIt);
+		}
+
+		nodes.push_back(in.mcCallback->buildNode(*leaf));
+		leaf->clean();
+		leaves.push_back(leaf);
+	}
+	state.resumeTiming();
+
+	const std::size_t n = leaves.size();
+	unsigned long patched = 0;
+
+	for (unsigned long it = 0; it < state.getIterations(); ++it) {
+		LeafNodeData &leaf = *leaves[it % n];
+
+		state.pauseTiming();
+		unsigned int e = 0;
+		GraphicData::List::iterator elmIt = leaf.getElements().begin();
+		for (; elmIt != leaf.getElements().end(); ++elmIt, ++e) {
+			if (e % CHANGE_STRIDE == 0)
+				leaf.updateElm(elmIt, *elmIt);
+		}
+		state.resumeTiming();
+
+		patched += in.mcCallback->patchNode(nodes[it % n].get(), leaf);
+		leaf.clean();
+	}
+
+	sink += patched;
+}
+
+static const Benchmark BENCHMARKS[] = {
+	{ "ShiftedBox::isIntersecting/SAT_fast", &benchFastSAT },
+	{ "ShiftedBox::isIntersecting/SAT_accurate", &benchAccurateSAT },
+	{ "ShiftedBox::isIntersecting/SAT_fast_radii", &benchFastTableSAT },
+	{ "ShiftedBox::isIntersecting/SAT_accurate_radii", &benchAccurateTableSAT },
+	{ "ShiftedBox::isIntersecting/AABB", &benchAABB },
+	{ "SphereCutter::getDistance", &benchSphereDistance },
+	{ "CylinderCutter::getDistance", &benchCylinderDistance },
+	{ "SphereCutter::getInsideCorners", &benchSphereInsideCorners },
+	{ "CylinderCutter::getInsideCorners", &benchCylinderInsideCorners },
+	{ "Octree::pushLeaf", &benchPushLeaf },
+	{ "MarchingCubeMesherCallback::buildNode", &benchMarchingCubeBuildNode },
+	{ "MarchingCubeMesherCallback::buildNode/welded", &benchMarchingCubeWeldedBuildNode },
+	{ "MarchingCubeMesherCallback::patchNode/10%", &benchMarchingCubePatchNode },
+};
+
+/*** INPUTS ***/
+
+/**
+ * builds all the kernels inputs
+ * @param cfp
+ * @param minVoxelSize
+ * @param maxMoves maximum number of moves to use
+ * @param in
+ */
+static void buildInput(const ConfigFileParser &cfp, float minVoxelSize,
+		unsigned long maxMoves, BenchInput &in) {
+
+	in.stockExtents = cfp.getStockDescription()->getGeometry()->asEigen();
+	unsigned int maxDepth = log(in.stockExtents.maxCoeff() / minVoxelSize) / log(2.0) + 1;
+	const Eigen::Vector3d leafExtents = in.stockExtents / (1 << maxDepth);
+
+	Cutter::Ptr cutter = Cutter::buildCutter(*cfp.getCutterDescription());
+	Cutter::BoundingBoxInfo bboxInfo = cutter->getBoundingBox();
+	in.bboxExtents = bboxInfo.extents;
+
+	// sphere and cylinder cutters as big as the configured one
+	const double radius = bboxInfo.extents[0] * 0.5;
+	in.sphere = boost::make_shared< SphereCutter >(Sphere(radius), cutter->getColor());
+	in.cylinder = boost::make_shared< CylinderCutter >(Cylinder(radius, bboxInfo.extents[2]),
+			cutter->getColor());
+
+	// same conversions done by the stock
+	const Eigen::Translation3d stockModelTraslation(in.stockExtents / 2.0);
+	boost::random::mt19937 rng(42);
+	boost::random::uniform_real_distribution< double > offset(-1, 1);
+
+	CNCMoveIterator it = cfp.CNCMoveBegin();
+	for (unsigned long m = 0; m < maxMoves && it != cfp.CNCMoveEnd(); ++m, ++it) {
+		const Eigen::Isometry3d cutterIsom_model = stockModelTraslation.inverse() * it.getCutterIsometry();
+		const Eigen::Isometry3d modelIsom_cutter = cutterIsom_model.inverse();
+		in.bboxIsoms_model.push_back(cutterIsom_model * bboxInfo.rototraslation);
+
+		ShiftedBox::MinMaxMatrix minMax;
+		ShiftedBox::calculateMinMax(minMax, in.bboxIsoms_model.back(), bboxInfo.extents);
+		in.bboxMinMaxs.push_back(minMax);
+
+		/* leaves are scattered around the cutter bounding box, so that
+		 * tests have both positive and negative outcomes
+		 */
+		Eigen::Vector3d center = in.bboxIsoms_model.back().translation();
+		for (int a = 0; a < 3; ++a) {
+			center[a] += offset(rng) * (bboxInfo.extents.maxCoeff() * 0.6 + leafExtents[a]);
+		}
+		ShiftedBox leaf(center, leafExtents);
+		in.leaves.push_back(leaf.getMatrix());
+
+		CornerCoords corners;
+		leaf.getCorners(modelIsom_cutter, corners);
+		in.corners.push_back(corners);
+		for (int c = 0; c < Corner::N_CORNERS; ++c) {
+			in.points.push_back(Eigen::Vector3d(corners.x[c], corners.y[c], corners.z[c]));
+		}
+	}
+
+	if (in.leaves.empty())
+		throw std::runtime_error("No moves to build inputs from");
+
+	// voxels of the milled stock, grouped as a mesher leaf would do
+	boost::shared_ptr< CapturingMesher > mesher = boost::make_shared< CapturingMesher >();
+	Stock::Ptr stock = boost::make_shared< Stock >(*cfp.getStockDescription(), maxDepth, mesher);
+	MillingAlgorithmConf conf(stock, cutter, cfp.CNCMoveBegin(), cfp.CNCMoveEnd(),
+			ALG_WATER_REMOTION_RATE, ALG_WATER_THRESHOLD, Stock::MAX_POSES);
+	MillingAlgorithm algorithm(conf);
+	for (unsigned long m = 0; m < maxMoves && algorithm.hasNextStep(); ++m) {
+		algorithm.step();
+	}
+	stock->getMeshing();
+
+	// same size of the leaves of MarchingCubeMesher
+	static const unsigned int MESH_LEAF_SIZE = 300;
+	in.mcCallback = new MarchingCubeMesherCallback(*cfp.getStockDescription());
+	in.mcWeldedCallback = new MarchingCubeMesherCallback(*cfp.getStockDescription(), true);
+
+	osg::ref_ptr< LeafNodeData > leaf;
+	bool intersecting = false;
+	StoredData::VoxelData::const_iterator vIt = mesher->voxels->begin();
+	for (; vIt != mesher->voxels->end(); ++vIt) {
+		if (!leaf.valid()) {
+			leaf = new LeafNodeData(vIt->sbox->asBoundingBox(), 0);
+			intersecting = false;
+		}
+		leaf->insertElm(*vIt);
+		intersecting |= vIt->isIntersecting();
+
+		if (leaf->getSize() == MESH_LEAF_SIZE) {
+			// leaves without cut voxels are never rebuilt
+			if (intersecting)
+				in.meshLeaves.push_back(leaf);
+			leaf = NULL;
+		}
+	}
+	if (leaf.valid() && intersecting)
+		in.meshLeaves.push_back(leaf);
+}
+
+/*** RUNNER ***/
+
+/**
+ *
+ * @param node a node built by a mesher callback
+ * @return bytes of the vertices, normals and indices owned by the node
+ * (shared arrays, as the ones of the colors, are not counted)
+ */
+static std::size_t getNodeBytes(osg::Node *node) {
+	osg::Geode *geode = dynamic_cast< osg::Geode * >(node);
+	if (geode == NULL)
+		return 0;
+
+	std::size_t bytes = 0;
+	for (unsigned int d = 0; d < geode->getNumDrawables(); ++d) {
+		osg::Geometry *geom = dynamic_cast< osg::Geometry * >(geode->getDrawable(d));
+		if (geom == NULL)
+			continue;
+
+		bytes += geom->getVertexArray()->getTotalDataSize();
+		// indexed normals are shared, only their indices are owned
+		if (geom->getNormalIndices() != NULL)
+			bytes += geom->getNormalIndices()->getTotalDataSize();
+		else
+			bytes += geom->getNormalArray()->getTotalDataSize();
+
+		for (unsigned int p = 0; p < geom->getNumPrimitiveSets(); ++p) {
+			bytes += geom->getPrimitiveSet(p)->getTotalDataSize();
+		}
+	}
+
+	return bytes;
+}
+
+/**
+ * prints the mean size of the mesh leaves built by the marching cubes,
+ * with and without welding their vertices
+ * @param in
+ */
+static void reportLeafBytes(const BenchInput &in) {
+	double bytes = 0, weldedBytes = 0;
+	for (std::size_t l = 0; l < in.meshLeaves.size(); ++l) {
+		bytes += getNodeBytes(in.mcCallback->buildNode(*in.meshLeaves[l]).get());
+		weldedBytes += getNodeBytes(in.mcWeldedCallback->buildNode(*in.meshLeaves[l]).get());
+	}
+
+	const double n = std::max< std::size_t >(in.meshLeaves.size(), 1);
+	cout << "Marching cubes bytes per leaf: " << fixed << setprecision(0)
+			<< bytes / n << " unindexed, " << weldedBytes / n << " welded ("
+			<< setprecision(2) << ((bytes > 0) ? weldedBytes / bytes : 0) << "x)" << endl;
+}
+
+/**
+ * runs a kernel increasing the number of iterations until it lasts at
+ * least the given time, then repeats it and keeps the best run
+ * @param bench
+ * @param in
+ * @param minTime
+ * @param repetitions
+ */
+static void run(const Benchmark &bench, const BenchInput &in, double minTime,
+		unsigned int repetitions) {
+
+	typedef boost::chrono::duration< double > Seconds;
+
+	unsigned long iterations = 1;
+	double elapsed;
+	while (true) {
+		BenchState state(iterations);
+		state.resumeTiming();
+		bench.kernel(state, in);
+		state.pauseTiming();
+
+		elapsed = boost::chrono::duration_cast< Seconds >(state.getElapsed()).count();
+		if (elapsed >= minTime)
+			break;
+
+		// aim at 1.5 * minTime, growing at most 10 times each attempt
+		double factor = (elapsed > 0) ? (minTime * 1.5 / elapsed) : 10;
+		iterations = std::max(iterations + 1, (unsigned long)(iterations * std::min(factor, 10.0)));
+	}
+
+	double best = elapsed;
+	for (unsigned int r = 1; r < repetitions; ++r) {
+		BenchState state(iterations);
+		state.resumeTiming();
+		bench.kernel(state, in);
+		state.pauseTiming();
+
+		best = std::min(best, boost::chrono::duration_cast< Seconds >(state.getElapsed()).count());
+	}
+
+	cout << left << setw(45) << bench.name << right
+			<< setw(14) << iterations
+			<< setw(14) << fixed << setprecision(2) << best * 1e9 / iterations
+			<< setw(16) << setprecision(0) << iterations / best
+			<< endl;
+}
+
+/**
+ * main
+ *
+ * @param argc : number of command-line parameters
+ * @param argv : the command-line parameters
+ * @return exit status of the program
+ */
+int main(int argc, char **argv) {
+
+	std::string configFile, filter;
+	float minVoxelSize;
+	double minTime;
+	unsigned int repetitions;
+	unsigned long maxMoves;
+
+	bpo::options_description description("Available options");
+	description.add_options()
+			("help,h", "produces this help message")
+			("config,c", bpo::value< std::string >(&configFile)->default_value(CMDLN_CONFFILE_NAME), "position of the configuration file")
+			("vsize,s", bpo::value< float >(&minVoxelSize)->default_value(CMDLN_MIN_VOXEL_SIZE), "minimum voxel size: all voxel dimensions should be equal or less then specified value")
+			("moves,n", bpo::value< unsigned long >(&maxMoves)->default_value(2000), "number of moves inputs are built from")
+			("filter,f", bpo::value< std::string >(&filter)->default_value(""), "runs only the benchmarks whose name contains the given string")
+			("time,t", bpo::value< double >(&minTime)->default_value(0.5), "minimum duration of each run (in seconds)")
+			("repetitions,r", bpo::value< unsigned int >(&repetitions)->default_value(3), "number of runs of each benchmark, the fastest is reported")
+	;
+	bpo::positional_options_description positionals;
+	positionals.add("config", -1);
+
+	bpo::variables_map vm;
+	bpo::store(bpo::command_line_parser(argc, argv).
+			options(description).
+			positional(positionals).run(),
+			vm);
+	bpo::notify(vm);
+
+	if (vm.count("help")) {
+		cout << "Usage: " << argv[0] << " [options] pointsFile" << endl;
+		cout << description << endl;
+		return 0;
+	}
+
+	ConfigFileParser cfp(configFile);
+	BenchInput input;
+	buildInput(cfp, minVoxelSize, maxMoves, input);
+
+	cout << "Inputs: " << input.leaves.size() << " poses, "
+			<< input.meshLeaves.size() << " mesh leaves" << endl;
+	reportLeafBytes(input);
+	cout << left << setw(45) << "benchmark" << right
+			<< setw(14) << "iterations"
+			<< setw(14) << "ns/op"
+			<< setw(16) << "op/s"
+			<< endl;
+
+	const unsigned int nBenchmarks = sizeof(BENCHMARKS) / sizeof(BENCHMARKS[0]);
+	for (unsigned int b = 0; b < nBenchmarks; ++b) {
+		if (std::string(BENCHMARKS[b].name).find(filter) != std::string::npos) {
+			run(BENCHMARKS[b], input, minTime, std::max(repetitions, 1u));
+		}
+	}
+
+	return 0;
+}
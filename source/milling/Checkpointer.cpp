@@ -0,0 +1,150 @@
+/*
+ * Checkpointer.cpp
+ *
+ *  Created on: 17/ott/2026
+ *      Author: socket
+ */
+
+#include "Checkpointer.hpp"
+
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <boost/bind.hpp>
+
+#include "common/Trace.hpp"
+
+Checkpointer::Checkpointer(const std::string &file, unsigned int retention) :
+	FILE_NAME(file), RETENTION(retention), stopping(false)
+{
+	if (retention == 0)
+		throw std::invalid_argument("checkpoint retention should be >0");
+
+	writer = boost::thread(boost::bind(&Checkpointer::writerLoop, this));
+}
+
+Checkpointer::~Checkpointer() {
+	{
+		UniqueLock l(mutex);
+		stopping = true;
+		pendingCond.notify_all();
+	}
+
+	writer.join();
+}
+
+void Checkpointer::submit(const Progress &progress,
+		const Stock::Snapshot::ConstPtr &snapshot) {
+
+	UniqueLock l(mutex);
+	pendingProgress = progress;
+	pendingSnapshot = snapshot;
+	pendingCond.notify_one();
+}
+
+void Checkpointer::write(const std::string &file, const Progress &progress,
+		const Stock::Snapshot &snapshot) throw(std::runtime_error) {
+
+	std::string tmpFile = writeAside(file, progress, snapshot);
+	if (std::rename(tmpFile.c_str(), file.c_str()) != 0) {
+		throw std::runtime_error("can't replace " + file);
+	}
+}
+
+Checkpointer::Progress Checkpointer::read(const std::string &file,
+		Stock &stock) throw(std::runtime_error) {
+
+	std::ifstream ifs(file.c_str(), std::ios_base::in | std::ios_base::binary);
+	if (!ifs.is_open()) {
+		throw std::runtime_error("can't read " + file);
+	}
+
+	Header header;
+	if (!ifs.read(reinterpret_cast< char * >(&header), sizeof(header)) ||
+			header.magic != MAGIC || header.version != VERSION) {
+		throw std::runtime_error(file + " is not a checkpoint, or has an unsupported version");
+	}
+
+	stock.loadModel(ifs);
+
+	return header.progress;
+}
+
+std::string Checkpointer::writeAside(const std::string &file, const Progress &progress,
+		const Stock::Snapshot &snapshot) throw(std::runtime_error) {
+
+	// so that a previous checkpoint survives a failure
+	const std::string tmpFile = file + ".tmp";
+
+	std::ofstream ofs(tmpFile.c_str(), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+	if (!ofs.is_open()) {
+		throw std::runtime_error("can't write " + tmpFile);
+	}
+
+	Header header;
+	header.magic = MAGIC;
+	header.version = VERSION;
+	header.progress = progress;
+	ofs.write(reinterpret_cast< const char * >(&header), sizeof(header));
+
+	snapshot.write(ofs);
+	ofs.close();
+
+	if (ofs.fail()) {
+		std::remove(tmpFile.c_str());
+		throw std::runtime_error("error writing " + tmpFile);
+	}
+
+	return tmpFile;
+}
+
+void Checkpointer::rotate() {
+	// missing checkpoints are simply skipped
+	for (unsigned int i = RETENTION - 1; i > 0; --i) {
+		std::ostringstream older, newer;
+		older << FILE_NAME << '.' << i;
+		newer << FILE_NAME;
+		if (i > 1) {
+			newer << '.' << (i - 1);
+		}
+
+		std::rename(newer.str().c_str(), older.str().c_str());
+	}
+}
+
+void Checkpointer::writerLoop() {
+	Trace::nameThread("checkpointer");
+
+	while (true) {
+		Stock::Snapshot::ConstPtr snapshot;
+		Progress progress;
+		{
+			UniqueLock l(mutex);
+			while (!pendingSnapshot && !stopping) {
+				pendingCond.wait(l);
+			}
+			if (!pendingSnapshot) {
+				return;
+			}
+
+			snapshot.swap(pendingSnapshot);
+			progress = pendingProgress;
+		}
+
+		Trace::Scope scope("checkpoint", "milling");
+
+		// a failed checkpoint is not worth stopping milling
+		try {
+			std::string tmpFile = writeAside(FILE_NAME, progress, *snapshot);
+			rotate();
+			if (std::rename(tmpFile.c_str(), FILE_NAME.c_str()) != 0) {
+				throw std::runtime_error("can't replace " + FILE_NAME);
+			}
+		} catch (const std::exception &e) {
+			std::cerr << "checkpoint not written: " << e.what() << std::endl;
+		}
+	}
+}
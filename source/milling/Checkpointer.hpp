@@ -0,0 +1,140 @@
+/**
+ * Checkpointer.hpp
+ *
+ *  Created on: 17/ott/2026
+ *      Author: socket
+ */
+
+#ifndef CHECKPOINTER_HPP_
+#define CHECKPOINTER_HPP_
+
+#include <stdexcept>
+#include <string>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread.hpp>
+
+#include "Stock.hpp"
+
+/**
+ * @class Checkpointer
+ *
+ * Writes milling checkpoints: a header with the milling progress followed
+ * by a snapshot of the stock (see Stock::takeSnapshot). Checkpoints can be
+ * written by the caller (#write) or handed to a dedicated thread
+ * (#submit), so that milling never waits for the disk. The latter keep
+ * the last checkpoints: the newest one is named as the given file and the
+ * older ones are numbered from 1 (file.1 is the previous one).
+ */
+class Checkpointer : boost::noncopyable {
+
+public:
+	/**
+	 * milling progress stored in a checkpoint
+	 */
+	struct Progress {
+		/** number of milled moves */
+		boost::uint64_t stepNumber;
+		double waterFluxWasteCount;
+	};
+
+private:
+	static const boost::uint32_t MAGIC = 0x4b434e43; // "CNCK"
+	static const boost::uint32_t VERSION = 1;
+
+	/**
+	 * header of the checkpoint files, followed by the stock snapshot
+	 */
+	struct Header {
+		boost::uint32_t magic;
+		boost::uint32_t version;
+		Progress progress;
+	};
+
+	typedef boost::unique_lock< boost::mutex > UniqueLock;
+
+	const std::string FILE_NAME;
+	const unsigned int RETENTION;
+
+	boost::mutex mutex;
+	boost::condition_variable pendingCond;
+
+	/** next checkpoint to write (NULL if none): a newer one replaces it */
+	Stock::Snapshot::ConstPtr pendingSnapshot;
+	Progress pendingProgress;
+	bool stopping;
+
+	boost::thread writer;
+
+public:
+	/**
+	 * constructor: starts the writer thread
+	 *
+	 * @param file name of the newest checkpoint
+	 * @param retention number of checkpoints kept, >0
+	 */
+	Checkpointer(const std::string &file, unsigned int retention);
+
+	/**
+	 * destructor: writes the pending checkpoint, if any, then stops the
+	 * writer thread
+	 */
+	virtual ~Checkpointer();
+
+	/**
+	 * hands a checkpoint to the writer thread without waiting for it: if
+	 * the writer is still busy with the previous one, the checkpoint
+	 * replaces the one waiting to be written, if any
+	 *
+	 * @param progress
+	 * @param snapshot
+	 */
+	void submit(const Progress &progress, const Stock::Snapshot::ConstPtr &snapshot);
+
+	/**
+	 * writes a checkpoint, replacing the given file only once the
+	 * checkpoint is complete
+	 *
+	 * @param file
+	 * @param progress
+	 * @param snapshot
+	 * @throw std::runtime_error if the file cannot be written
+	 */
+	static void write(const std::string &file, const Progress &progress,
+			const Stock::Snapshot &snapshot) throw(std::runtime_error);
+
+	/**
+	 * reads a checkpoint, loading its snapshot into the given stock (see
+	 * Stock::loadModel)
+	 *
+	 * @param file
+	 * @param stock
+	 * @return the milling progress
+	 * @throw std::runtime_error if the checkpoint cannot be read or loaded
+	 */
+	static Progress read(const std::string &file, Stock &stock) throw(std::runtime_error);
+
+private:
+	/**
+	 * writes a checkpoint next to the given file
+	 *
+	 * @param file
+	 * @param progress
+	 * @param snapshot
+	 * @return the name of the written file
+	 * @throw std::runtime_error if the file cannot be written
+	 */
+	static std::string writeAside(const std::string &file, const Progress &progress,
+			const Stock::Snapshot &snapshot) throw(std::runtime_error);
+
+	/**
+	 * shifts the numbers of the kept checkpoints, the newest one included,
+	 * forgetting the oldest one
+	 */
+	void rotate();
+
+	void writerLoop();
+};
+
+#endif /* CHECKPOINTER_HPP_ */
@@ -69,6 +69,19 @@ public:
 	
 };
 
+/**
+ * @class CornerCoords
+ *
+ * coordinates of the 8 corners of a box stored axis by axis (structure of
+ * arrays), indexed by Corner::CornerType, so that corners can be processed
+ * all together by vectorized code
+ */
+struct CornerCoords {
+	double x[Corner::N_CORNERS];
+	double y[Corner::N_CORNERS];
+	double z[Corner::N_CORNERS];
+};
+
 /**
  * @class CornerIterator
  *
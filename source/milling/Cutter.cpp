@@ -11,6 +11,18 @@
 
 #include "configuration/Geometry.hpp"
 #include "cutters.hpp"
+#include "VoxelInfo.hpp"
+
+unsigned char Cutter::getInsideCorners(const CornerCoords &corners) const {
+	unsigned char inside = 0;
+	
+	for (int c = 0; c < Corner::N_CORNERS; ++c) {
+		Eigen::Vector3d point(corners.x[c], corners.y[c], corners.z[c]);
+		inside |= ((int)VoxelInfo::isInside(getDistance(point))) << c;
+	}
+	
+	return inside;
+}
 
 Cutter::Ptr Cutter::buildCutter(const CutterDescription &desc) {
 	
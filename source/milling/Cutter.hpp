@@ -8,11 +8,14 @@
 #ifndef CUTTER_HPP_
 #define CUTTER_HPP_
 
+#include <stdexcept>
+
 #include <boost/shared_ptr.hpp>
 
 #include "common/Color.hpp"
 #include "common/Point3D.hpp"
 #include "common/Model3D.hpp"
+#include "Corner.hpp"
 #include "configuration/CutterDescription.hpp"
 
 class Cutter;
@@ -80,6 +83,30 @@ public:
 	 */
 	virtual double getDistance(const Eigen::Vector3d &point) const =0;
 	
+	/**
+	 * tests all the corners of a box at once
+	 * 
+	 * @param corners in cutter basis
+	 * @return mask with the i-th bit set if the i-th corner is inside the
+	 * cutter, following #getDistance conventions
+	 */
+	virtual unsigned char getInsideCorners(const CornerCoords &corners) const;
+	
+	/**
+	 * distance from the volume swept by the cutter while translating,
+	 * without rotating, from its origin to \c movement. Same conventions of
+	 * #getDistance are used.
+	 * 
+	 * @param point in cutter basis
+	 * @param movement translation of the cutter, in cutter basis
+	 * @return >=0 => inside, <0 => outside
+	 * @throw std::runtime_error if the cutter does not support swept volumes
+	 */
+	virtual double getSweptDistance(const Eigen::Vector3d &point,
+			const Eigen::Vector3d &movement) const {
+		throw std::runtime_error("Swept volume not supported by this cutter");
+	}
+	
 	struct BoundingBoxInfo {
 		BoundingBoxInfo(const Eigen::Vector3d &extents, const Eigen::Isometry3d &rototrasl) :
 			extents(extents), rototraslation(rototrasl)
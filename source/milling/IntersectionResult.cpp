@@ -11,7 +11,8 @@
 
 IntersectionResult::IntersectionResult() :
 	waste(0), analyzed_leaves(0), purged_leaves(0),
-	pushed_leaves(0), updated_data_leaves(0), elapsedTime(0)
+	pushed_leaves(0), updated_data_leaves(0),
+	descent_cache_hits(0), descent_cache_misses(0), elapsedTime(0)
 { }
 
 IntersectionResult::~IntersectionResult() { }
@@ -30,6 +31,8 @@ IntersectionResult & IntersectionResult::operator+=(const IntersectionResult &ot
 	purged_leaves += other.purged_leaves;
 	pushed_leaves += other.pushed_leaves;
 	updated_data_leaves += other.updated_data_leaves;
+	descent_cache_hits += other.descent_cache_hits;
+	descent_cache_misses += other.descent_cache_misses;
 	elapsedTime += other.elapsedTime;
 	
 	return *this;
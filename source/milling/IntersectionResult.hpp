@@ -34,6 +34,12 @@ public:
 	
 	unsigned long updated_data_leaves;
 	
+	/** passes whose descent started from the branch cached by the previous one */
+	unsigned long descent_cache_hits;
+	
+	/** passes whose descent could not start from the cached branch */
+	unsigned long descent_cache_misses;
+	
 	boost::chrono::microseconds elapsedTime;
 
 	/**
@@ -9,12 +9,14 @@
 
 #include <cmath>
 #include <stdexcept>
+#include <vector>
 
 #include <boost/make_shared.hpp>
 
 #include <Eigen/Geometry>
 
 #include "common/constants.hpp"
+#include "common/Trace.hpp"
 #include "common/Point3D.hpp"
 #include "common/EulerAngles.hpp"
 #include "Cutter.hpp"
@@ -25,6 +27,22 @@ MillingAlgorithm::MillingAlgorithm(const MillingAlgorithmConf &conf) :
 {
 	this->waterFluxWasteCount = 0;
 	this->stepNumber = 0;
+	this->mergedBranches = 0;
+	
+	if (!CONFIG.resumeFile.empty()) {
+		resume(CONFIG.resumeFile);
+	}
+	
+	if (CONFIG.prefetchDepth > 0) {
+		prefetcher.reset(new MovePrefetcher(CONFIG.MOVE_IT, CONFIG.MOVE_END,
+				CONFIG.prefetchDepth));
+	}
+	
+	if (!CONFIG.checkpoint.file.empty()) {
+		checkpointer.reset(new Checkpointer(CONFIG.checkpoint.file,
+				CONFIG.checkpoint.retention));
+		lastCheckpointTime = boost::chrono::steady_clock::now();
+	}
 }
 
 MillingAlgorithm::~MillingAlgorithm() { }
@@ -32,60 +50,158 @@ MillingAlgorithm::~MillingAlgorithm() { }
 MillingAlgorithm::StepInfo MillingAlgorithm::step() {
 	assert(hasNextStep());
 	
-	this->stepNumber++;
+	if (pendingSteps.empty()) {
+		millNextBatch();
+	}
+	
+	StepInfo info = pendingSteps.front();
+	pendingSteps.pop_front();
+	
+	return info;
+}
+
+void MillingAlgorithm::millNextBatch() {
+	std::vector< CNCMove > moves;
+	Stock::PoseList poses;
+	
+	if (prefetcher) {
+		prefetcher->pop(CONFIG.batchSize, moves, poses);
+	} else {
+		while (moves.size() < CONFIG.batchSize && CONFIG.MOVE_IT != CONFIG.MOVE_END) {
+			moves.push_back(*CONFIG.MOVE_IT);
+			poses.push_back(CONFIG.MOVE_IT.getCutterIsometry());
+			++(CONFIG.MOVE_IT);
+		}
+	}
+	
+	const unsigned int firstStep = this->stepNumber;
+	
+	Stock::ResultList results;
+	if (CONFIG.sweep) {
+		// first move has no segment leading to it
+		const Eigen::Isometry3d &start = lastPose.empty() ? poses.front() : lastPose.front();
+		results = CONFIG.STOCK->intersectPath(CONFIG.CUTTER, start, poses);
+		
+		lastPose.assign(1, poses.back());
+	} else {
+		results = CONFIG.STOCK->intersect(CONFIG.CUTTER, poses);
+	}
+	
+	for (unsigned int i = 0; i < moves.size(); ++i) {
+		this->stepNumber++;
+		
+		bool water = false;
+		this->waterFluxWasteCount += results[i].waste;
+		if (this->waterFluxWasteCount > CONFIG.waterThreshold) {
+			this->waterFluxWasteCount = std::max< double >(0, 
+					this->waterFluxWasteCount - CONFIG.waterFlux);
+			water = true;
+		}
+		
+		pendingSteps.push_back(StepInfo(MillingResult(this->stepNumber, results[i], water), moves[i]));
+	}
+	
+	// checkpoints are taken after compaction, so they are smaller
+	if (CONFIG.compactEvery > 0 &&
+			firstStep / CONFIG.compactEvery < this->stepNumber / CONFIG.compactEvery) {
+		this->mergedBranches += CONFIG.STOCK->compact();
+	}
+	
+	if (checkpointer && isCheckpointDue(firstStep)) {
+		/* only the top of the model is copied here: the checkpointer thread
+		 * copies the rest while writing it (see Stock::Snapshot)
+		 */
+		checkpointer->submit(getProgress(), CONFIG.STOCK->takeSnapshot());
+		lastCheckpointTime = boost::chrono::steady_clock::now();
+	}
+}
+
+bool MillingAlgorithm::isCheckpointDue(unsigned int firstStep) const {
+	const CheckpointConf &conf = CONFIG.checkpoint;
+	
+	if (conf.step > 0 && firstStep < conf.step && conf.step <= this->stepNumber) {
+		return true;
+	}
+	if (conf.everyMoves > 0 && firstStep / conf.everyMoves < this->stepNumber / conf.everyMoves) {
+		return true;
+	}
+	return conf.everySeconds > 0 && boost::chrono::steady_clock::now() - lastCheckpointTime >=
+			boost::chrono::seconds(conf.everySeconds);
+}
+
+Checkpointer::Progress MillingAlgorithm::getProgress() const {
+	Checkpointer::Progress progress;
+	progress.stepNumber = this->stepNumber;
+	progress.waterFluxWasteCount = this->waterFluxWasteCount;
+	
+	return progress;
+}
+
+void MillingAlgorithm::saveCheckpoint(const std::string &file) const {
+	Trace::Scope scope("saveCheckpoint", "milling");
+	
+	Checkpointer::write(file, getProgress(), *CONFIG.STOCK->takeSnapshot());
+}
+
+void MillingAlgorithm::resume(const std::string &file) {
+	Trace::Scope scope("resume", "milling");
 	
-	const CNCMove &move = *CONFIG.MOVE_IT;
-	IntersectionResult infos = doIntersection(move);
+	Checkpointer::Progress progress = Checkpointer::read(file, *CONFIG.STOCK);
 	
-	bool water = false;
-	this->waterFluxWasteCount += infos.waste;
-	if (this->waterFluxWasteCount > CONFIG.waterThreshold) {
-		this->waterFluxWasteCount = std::max< double >(0, 
-				this->waterFluxWasteCount - CONFIG.waterFlux);
-		water = true;
+	// moves are skipped, but the last one is where a sweep restarts from
+	for (boost::uint64_t i = 0; i < progress.stepNumber; ++i) {
+		if (CONFIG.MOVE_IT == CONFIG.MOVE_END) {
+			throw std::runtime_error(file + " is beyond the end of the moves");
+		}
+		if (CONFIG.sweep && i + 1 == progress.stepNumber) {
+			lastPose.assign(1, CONFIG.MOVE_IT.getCutterIsometry());
+		}
+		++(CONFIG.MOVE_IT);
 	}
-			
-	++(CONFIG.MOVE_IT);
-	return StepInfo(MillingResult(this->stepNumber, infos, water), move);
+	
+	this->stepNumber = progress.stepNumber;
+	this->waterFluxWasteCount = progress.waterFluxWasteCount;
 }
 
 bool MillingAlgorithm::hasNextStep() {
-	return CONFIG.MOVE_IT != CONFIG.MOVE_END;
+	if (!pendingSteps.empty())
+		return true;
+	
+	/* the prefetcher reads from its own copy of the iterator, so
+	 * CONFIG.MOVE_IT stays at the first move it was handed
+	 */
+	return prefetcher ? prefetcher->hasNext() : CONFIG.MOVE_IT != CONFIG.MOVE_END;
 }
 
 unsigned int MillingAlgorithm::getStepNumber() {
 	return this->stepNumber;
 }
 
-Eigen::Vector3d MillingAlgorithm::getResolution() const {
-	return CONFIG.STOCK->getResolution();
+unsigned int MillingAlgorithm::getPendingSteps() const {
+	return pendingSteps.size();
 }
 
-IntersectionResult MillingAlgorithm::doIntersection(const CNCMove &move) {
-	
-	/** given move rototraslations are in respect of world basis so we have
-	 * to "merge" this two informations in order to find cutter rototraslation
-	 * in stock basis.
-	 *
-	 * When returned as eigen both these isometry are matrices that
-	 * converts point from stock/cutter coords to world ones: i.e. they
-	 * convert from stock/cutter basis to world basis; we have to create 
-	 * an isometry that converts from cutter coords to stock coords.
-	 * 
-	 * P_world = StockIsom_world * P_stock
-	 * P'_world = CutterIsom_world * P'_cutter
-	 * P''_stock = inverse(StockIsom_world) * P''_world
-	 * 
-	 * P3_stock = inverse(StockIsom_world) * CutterIsom_world * P3_cutter
-	 */
-	Eigen::Isometry3d cutterIsom_stock = move.STOCK.asEigen().inverse() * move.CUTTER.asEigen();
-	
-	return CONFIG.STOCK->intersect(CONFIG.CUTTER, cutterIsom_stock);
+unsigned long MillingAlgorithm::getPrefetchStalls() const {
+	return prefetcher ? prefetcher->getStallsNumber() : 0;
+}
+
+unsigned long MillingAlgorithm::getMergedBranches() const {
+	return this->mergedBranches;
+}
+
+Eigen::Vector3d MillingAlgorithm::getResolution() const {
+	return CONFIG.STOCK->getResolution();
 }
 
 std::ostream& operator <<(std::ostream& os, const MillingAlgorithm& ma) {
 	os << "MILLING_ALGORITHM(currStep#:" << ma.stepNumber << "; next_move:";
-	if (ma.CONFIG.MOVE_IT == ma.CONFIG.MOVE_END)
+	if (ma.prefetcher) {
+		CNCMove next;
+		if (ma.prefetcher->peek(next))
+			os << next;
+		else
+			os << "ENDED";
+	} else if (ma.CONFIG.MOVE_IT == ma.CONFIG.MOVE_END)
 		os << "ENDED";
 	else
 		os << *(ma.CONFIG.MOVE_IT);
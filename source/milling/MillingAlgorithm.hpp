@@ -8,16 +8,22 @@
 #ifndef MILLINGALGORITHM_HPP_
 #define MILLINGALGORITHM_HPP_
 
+#include <deque>
 #include <ostream>
+#include <string>
 #include <utility>
 
+#include <boost/chrono.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
 
 #include "configuration/ConfigFileParser.hpp"
 #include "Cutter.hpp"
 #include "Stock.hpp"
 #include "MillingResult.hpp"
 #include "MillingAlgorithmConf.hpp"
+#include "Checkpointer.hpp"
+#include "MovePrefetcher.hpp"
 
 /**
  * executes milling, one step a time
@@ -35,6 +41,21 @@ private:
 	double waterFluxWasteCount;
 	unsigned int stepNumber;
 	
+	/** number of stock branches merged by compactions */
+	unsigned long mergedBranches;
+	
+	/** steps already milled but not yet returned by #step */
+	std::deque< StepInfo > pendingSteps;
+	
+	/** cutter pose of the last milled move (empty before the first one) */
+	Stock::PoseList lastPose;
+	
+	/** reads moves ahead of milling (NULL if moves are read when needed) */
+	boost::scoped_ptr< MovePrefetcher > prefetcher;
+	
+	/** writes checkpoints while milling (NULL if there are none) */
+	boost::scoped_ptr< Checkpointer > checkpointer;
+	boost::chrono::steady_clock::time_point lastCheckpointTime;
 	
 public:
 	/**
@@ -46,7 +67,9 @@ public:
 	virtual ~MillingAlgorithm();
 	
 	/**
-	 * advances milling one step a time
+	 * advances milling one step a time: when configured batch size is
+	 * greater than 1 the following moves are milled together and their
+	 * results are returned by the next calls
 	 * @return
 	 */
 	StepInfo step();
@@ -59,6 +82,38 @@ public:
 	
 	unsigned int getStepNumber();
 	
+	/**
+	 *
+	 * @return the number of steps already milled and not yet returned by
+	 * #step: when 0 the next call mills a new batch
+	 */
+	unsigned int getPendingSteps() const;
+	
+	/**
+	 *
+	 * @return the number of times milling waited for moves to be read
+	 * (always 0 if moves are not prefetched)
+	 */
+	unsigned long getPrefetchStalls() const;
+	
+	/**
+	 *
+	 * @return the number of stock branches merged into leaves by the
+	 * periodic compactions
+	 */
+	unsigned long getMergedBranches() const;
+	
+	/**
+	 * writes the milling progress and a snapshot of the stock to a file
+	 * (see Checkpointer::write). Moves milled but not yet returned by
+	 * #step are included, so with batches the checkpoint is at the end of
+	 * the last milled batch.
+	 * 
+	 * @param file
+	 * @throw std::runtime_error if the file cannot be written
+	 */
+	void saveCheckpoint(const std::string &file) const;
+	
 	/**
 	 * Returns dimensions of the smallest voxel in which STOCK will be divided.
 	 * @return
@@ -74,7 +129,35 @@ public:
 	
 private:
 	
-	IntersectionResult doIntersection(const CNCMove &move);
+	/**
+	 * mills the next batch of moves filling #pendingSteps
+	 */
+	void millNextBatch();
+	
+	/**
+	 *
+	 * @param firstStep step number before the last milled batch
+	 * @return True if a checkpoint has to be written after the last
+	 * milled batch
+	 */
+	bool isCheckpointDue(unsigned int firstStep) const;
+	
+	/**
+	 *
+	 * @return the progress to be stored in a checkpoint
+	 */
+	Checkpointer::Progress getProgress() const;
+	
+	/**
+	 * loads the stock and the milling progress from a checkpoint,
+	 * skipping the moves already milled: it must be called before moves
+	 * are prefetched
+	 * 
+	 * @param file
+	 * @throw std::runtime_error if the checkpoint cannot be read or is
+	 * beyond the end of the moves
+	 */
+	void resume(const std::string &file);
 	
 };
 
@@ -8,10 +8,55 @@
 #ifndef MILLINGALGORITHMCONF_HPP_
 #define MILLINGALGORITHMCONF_HPP_
 
+#include <stdexcept>
+#include <string>
+
 #include "Stock.hpp"
 #include "Cutter.hpp"
 #include "configuration/CNCMoveIterator.hpp"
 
+/**
+ * @class CheckpointConf
+ *
+ * when milling checkpoints are written (see Checkpointer): each enabled
+ * condition is checked at the end of every milled batch
+ */
+class CheckpointConf {
+public:
+	
+	/**
+	 * constructor
+	 *
+	 * @param file name of the newest checkpoint, empty for no checkpoint
+	 * @param step a checkpoint is written once this number of moves is
+	 * milled (0 to disable)
+	 * @param everyMoves a checkpoint is written every this number of
+	 * milled moves (0 to disable)
+	 * @param everySeconds a checkpoint is written every this number of
+	 * seconds of milling (0 to disable)
+	 * @param retention number of checkpoints kept, >0
+	 */
+	CheckpointConf(const std::string &file = "", unsigned int step = 0,
+			unsigned int everyMoves = 0, unsigned int everySeconds = 0,
+			unsigned int retention = 1) :
+				file(file), step(step), everyMoves(everyMoves),
+				everySeconds(everySeconds), retention(retention)
+	{
+		if (!file.empty() && step == 0 && everyMoves == 0 && everySeconds == 0)
+			throw std::invalid_argument("checkpoint step, moves or seconds should be >0");
+		if (retention == 0)
+			throw std::invalid_argument("checkpoint retention should be >0");
+	}
+	
+	virtual ~CheckpointConf() { }
+	
+	const std::string file;
+	const unsigned int step;
+	const unsigned int everyMoves;
+	const unsigned int everySeconds;
+	const unsigned int retention;
+};
+
 /**
  * @class MillingAlgorithmConf
  *
@@ -29,14 +74,35 @@ public:
 	 * @param end
 	 * @param waterRemotionRate
 	 * @param waterThreshold
+	 * @param batchSize number of moves intersected by the stock in a single
+	 * pass, in [1, Stock::MAX_POSES]
+	 * @param sweep True if the cutter removes all the material met moving
+	 * along the linear segment between two consecutive moves, False if it
+	 * mills only at the moves positions
+	 * @param prefetchDepth number of moves read ahead by a dedicated thread,
+	 * 0 to read them on the milling thread when needed
+	 * @param checkpoint when milling checkpoints are written
+	 * @param resumeFile checkpoint milling is resumed from, empty to begin
+	 * from the first move
+	 * @param compactEvery the stock is compacted (see Stock::compact) every
+	 * this number of milled moves, 0 to never compact it: compactions
+	 * slightly approximate the waste count
 	 */
 	MillingAlgorithmConf(Stock::Ptr stock, Cutter::ConstPtr cutter,
 			const CNCMoveIterator &begin, const CNCMoveIterator &end,
-			float waterRemotionRate, float waterThreshold) :
+			float waterRemotionRate, float waterThreshold,
+			unsigned int batchSize = 1, bool sweep = false,
+			unsigned int prefetchDepth = 0,
+			const CheckpointConf &checkpoint = CheckpointConf(),
+			const std::string &resumeFile = "", unsigned int compactEvery = 0) :
 				STOCK(stock), CUTTER(cutter), MOVE_IT(begin), MOVE_END(end),
-				waterFlux(waterRemotionRate), waterThreshold(waterThreshold)
+				waterFlux(waterRemotionRate), waterThreshold(waterThreshold),
+				batchSize(batchSize), sweep(sweep), prefetchDepth(prefetchDepth),
+				checkpoint(checkpoint), resumeFile(resumeFile),
+				compactEvery(compactEvery)
 	{
-		
+		if (batchSize == 0 || batchSize > Stock::MAX_POSES)
+			throw std::invalid_argument("batch size should be in [1, Stock::MAX_POSES]");
 	}
 				
 	virtual ~MillingAlgorithmConf() { }
@@ -46,6 +112,12 @@ public:
 	CNCMoveIterator MOVE_IT, MOVE_END;
 	const float waterFlux;
 	const float waterThreshold;
+	const unsigned int batchSize;
+	const bool sweep;
+	const unsigned int prefetchDepth;
+	const CheckpointConf checkpoint;
+	const std::string resumeFile;
+	const unsigned int compactEvery;
 };
 
 #endif /* MILLINGALGORITHMCONF_HPP_ */
@@ -0,0 +1,138 @@
+/**
+ * MortonCode.hpp
+ *
+ *  Created on: 17/ott/2026
+ *      Author: socket
+ */
+
+#ifndef MORTONCODE_HPP_
+#define MORTONCODE_HPP_
+
+#include <cassert>
+
+#include <boost/cstdint.hpp>
+
+/**
+ * @class MortonCode
+ *
+ * Locational codes for octree nodes. The code of a node is built appending,
+ * from the root down to the node, the 3 bits of each child index to a
+ * leading '1' (the root code) that works as a sentinel: in this way codes of
+ * nodes at different depths never collide.
+ *
+ * Child indexes are the ones built by Octree: bit 2 selects the X half, bit 1
+ * the Y half and bit 0 the Z half of the father box, so that, once the
+ * sentinel is removed, the code is the Morton (Z-order) interleaving of the
+ * node integer coordinates inside the grid of its depth.
+ */
+class MortonCode {
+
+public:
+	typedef boost::uint64_t CodeType;
+
+	/**
+	 * maximum depth a node can have without overflowing CodeType
+	 */
+	static const unsigned int MAX_DEPTH = 21;
+
+	static const CodeType ROOT = 1;
+
+public:
+
+	/**
+	 *
+	 * @param father
+	 * @param childIdx
+	 * @return code of the \c childIdx-th child of \c father
+	 */
+	inline
+	static CodeType child(CodeType father, unsigned char childIdx) {
+		assert(childIdx < 8);
+		return (father << 3) | childIdx;
+	}
+
+	/**
+	 *
+	 * @param code
+	 * @return index of the node inside its father
+	 */
+	inline
+	static unsigned char childIdx(CodeType code) {
+		return code & 0x07;
+	}
+
+	/**
+	 *
+	 * @param code
+	 * @return code of the node father
+	 */
+	inline
+	static CodeType father(CodeType code) {
+		return code >> 3;
+	}
+
+	/**
+	 *
+	 * @param code
+	 * @return depth of the node owning \c code
+	 */
+	inline
+	static unsigned int depth(CodeType code) {
+		assert(code != 0);
+
+		unsigned int msb = 0;
+#ifdef __GNUC__
+		msb = 63 - __builtin_clzll(code);
+#else
+		while (code >>= 1) {
+			++msb;
+		}
+#endif
+		return msb / 3;
+	}
+
+	/**
+	 * Extracts node integer coordinates: each coordinate is in
+	 * [0, 2^depth[ and counts how many boxes of the node size are placed,
+	 * along that axis, between the octree origin and the node.
+	 *
+	 * @param code
+	 * @param depth depth of the node owning \c code
+	 * @param coords output coordinates (X, Y, Z)
+	 */
+	inline
+	static void decode(CodeType code, unsigned int depth, boost::uint32_t coords[3]) {
+		assert(depth <= MAX_DEPTH);
+		assert((code >> (3 * depth)) == ROOT);
+
+		// remove sentinel bit
+		code ^= ROOT << (3 * depth);
+
+		coords[0] = compact(code >> 2);
+		coords[1] = compact(code >> 1);
+		coords[2] = compact(code);
+	}
+
+private:
+
+	/**
+	 * Keeps one bit every three (starting from the less significant one)
+	 * and packs them together
+	 *
+	 * @param x
+	 * @return
+	 */
+	inline
+	static boost::uint32_t compact(CodeType x) {
+		x &= 0x1249249249249249ULL;
+		x = (x ^ (x >> 2)) & 0x10c30c30c30c30c3ULL;
+		x = (x ^ (x >> 4)) & 0x100f00f00f00f00fULL;
+		x = (x ^ (x >> 8)) & 0x001f0000ff0000ffULL;
+		x = (x ^ (x >> 16)) & 0x001f00000000ffffULL;
+		x = (x ^ (x >> 32)) & 0x00000000001fffffULL;
+
+		return static_cast< boost::uint32_t >(x);
+	}
+};
+
+#endif /* MORTONCODE_HPP_ */
@@ -0,0 +1,132 @@
+/*
+ * MovePrefetcher.cpp
+ *
+ *  Created on: 17/ott/2026
+ *      Author: socket
+ */
+
+#include "MovePrefetcher.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+
+#include <boost/bind.hpp>
+
+#include "common/Trace.hpp"
+
+MovePrefetcher::MovePrefetcher(const CNCMoveIterator &begin,
+		const CNCMoveIterator &end, unsigned int depth) :
+	moveIt(begin), MOVE_END(end), moves(depth), poses(depth), head(0), count(0),
+	finished(false), stopping(false), stalls(0)
+{
+	if (depth == 0)
+		throw std::invalid_argument("prefetch depth should be >0");
+
+	producer = boost::thread(boost::bind(&MovePrefetcher::producerLoop, this));
+}
+
+MovePrefetcher::~MovePrefetcher() {
+	{
+		UniqueLock l(mutex);
+		stopping = true;
+		notFull.notify_all();
+	}
+
+	producer.join();
+}
+
+bool MovePrefetcher::hasNext() {
+	UniqueLock l(mutex);
+	waitNotEmpty(l);
+
+	return count > 0;
+}
+
+bool MovePrefetcher::peek(CNCMove &move) {
+	UniqueLock l(mutex);
+	waitNotEmpty(l);
+
+	if (count == 0)
+		return false;
+
+	move = moves[head];
+	return true;
+}
+
+unsigned int MovePrefetcher::pop(unsigned int maxMoves,
+		std::vector< CNCMove > &popMoves, Stock::PoseList &popPoses) {
+
+	UniqueLock l(mutex);
+	waitNotEmpty(l);
+
+	unsigned int nPopped = std::min(maxMoves, count);
+	for (unsigned int i = 0; i < nPopped; ++i) {
+		popMoves.push_back(moves[head]);
+		popPoses.push_back(poses[head]);
+		head = (head + 1) % moves.size();
+	}
+	count -= nPopped;
+
+	if (nPopped > 0) {
+		notFull.notify_one();
+	}
+
+	return nPopped;
+}
+
+unsigned long MovePrefetcher::getStallsNumber() const {
+	return stalls.get();
+}
+
+unsigned int MovePrefetcher::getDepth() const {
+	return moves.size();
+}
+
+void MovePrefetcher::waitNotEmpty(UniqueLock &lock) {
+	if (count == 0 && !finished) {
+		stalls.incAndGet();
+
+		do {
+			notEmpty.wait(lock);
+		} while (count == 0 && !finished);
+	}
+
+	if (count == 0 && !error.empty()) {
+		throw std::runtime_error(error);
+	}
+}
+
+void MovePrefetcher::producerLoop() {
+	Trace::nameThread("move prefetcher");
+
+	try {
+		while (moveIt != MOVE_END) {
+			// parse outside the lock, so that the miller never waits for it
+			CNCMove move = *moveIt;
+			Eigen::Isometry3d pose = moveIt.getCutterIsometry();
+			++moveIt;
+
+			UniqueLock l(mutex);
+			while (count == moves.size() && !stopping) {
+				notFull.wait(l);
+			}
+			if (stopping) {
+				return;
+			}
+
+			unsigned int tail = (head + count) % moves.size();
+			moves[tail] = move;
+			poses[tail] = pose;
+			count++;
+			notEmpty.notify_one();
+		}
+	} catch (const std::exception &e) {
+		UniqueLock l(mutex);
+		error = e.what();
+	}
+
+	UniqueLock l(mutex);
+	finished = true;
+	notEmpty.notify_all();
+}
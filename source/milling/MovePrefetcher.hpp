@@ -0,0 +1,121 @@
+/**
+ * MovePrefetcher.hpp
+ *
+ *  Created on: 17/ott/2026
+ *      Author: socket
+ */
+
+#ifndef MOVEPREFETCHER_HPP_
+#define MOVEPREFETCHER_HPP_
+
+#include <string>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+#include <boost/thread.hpp>
+
+#include "configuration/CNCMoveIterator.hpp"
+#include "common/AtomicNumber.hpp"
+#include "Stock.hpp"
+
+/**
+ * @class MovePrefetcher
+ *
+ * Pipeline stage that reads moves ahead of milling: a dedicated thread
+ * parses moves and computes their cutter poses, storing them in a bounded
+ * ring buffer from which the milling thread pops them. Parsing is thus
+ * overlapped with stock traversals, and the buffer bounds the memory used
+ * when the parser is faster than milling.
+ */
+class MovePrefetcher : boost::noncopyable {
+
+private:
+	typedef boost::unique_lock< boost::mutex > UniqueLock;
+
+	CNCMoveIterator moveIt;
+	const CNCMoveIterator MOVE_END;
+
+	/** ring buffer: #count entries starting from #head */
+	std::vector< CNCMove > moves;
+	Stock::PoseList poses;
+	unsigned int head, count;
+
+	boost::mutex mutex;
+	boost::condition_variable notEmpty, notFull;
+	bool finished, stopping;
+	std::string error;
+
+	// only read as a statistic: no ordering with other memory is needed
+	AtomicNumber< unsigned long, AtomicOrder::RELAXED > stalls;
+
+	boost::thread producer;
+
+public:
+	/**
+	 * constructor: starts reading moves
+	 *
+	 * @param begin
+	 * @param end
+	 * @param depth maximum number of moves read ahead, >0
+	 */
+	MovePrefetcher(const CNCMoveIterator &begin, const CNCMoveIterator &end,
+			unsigned int depth);
+
+	/**
+	 * destructor: stops reading moves
+	 */
+	virtual ~MovePrefetcher();
+
+	/**
+	 * waits until a move is available or all moves have been read
+	 *
+	 * @return True if there are other moves to pop
+	 * @throw std::runtime_error if reading moves failed
+	 */
+	bool hasNext();
+
+	/**
+	 * copies the next move to pop, waiting for it like #hasNext
+	 *
+	 * @param move where the move is copied
+	 * @return True if there is a move to pop, False if all moves were popped
+	 * @throw std::runtime_error if reading moves failed
+	 */
+	bool peek(CNCMove &move);
+
+	/**
+	 * pops next moves, waiting for the first one if none is available
+	 *
+	 * @param maxMoves maximum number of popped moves
+	 * @param popMoves vector where popped moves are appended
+	 * @param popPoses vector where cutter poses of popped moves are appended
+	 * @return the number of popped moves, 0 only if all moves were popped
+	 * @throw std::runtime_error if reading moves failed
+	 */
+	unsigned int pop(unsigned int maxMoves, std::vector< CNCMove > &popMoves,
+			Stock::PoseList &popPoses);
+
+	/**
+	 *
+	 * @return the number of times the milling thread had to wait for
+	 * moves to be read
+	 */
+	unsigned long getStallsNumber() const;
+
+	/**
+	 *
+	 * @return the maximum number of moves read ahead
+	 */
+	unsigned int getDepth() const;
+
+private:
+	/**
+	 * waits until the buffer is not empty or all moves have been read
+	 * @param lock lock on #mutex
+	 */
+	void waitNotEmpty(UniqueLock &lock);
+
+	void producerLoop();
+};
+
+#endif /* MOVEPREFETCHER_HPP_ */
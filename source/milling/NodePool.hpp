@@ -0,0 +1,118 @@
+/**
+ * NodePool.hpp
+ *
+ *  Created on: 17/ott/2026
+ *      Author: socket
+ */
+
+#ifndef NODEPOOL_HPP_
+#define NODEPOOL_HPP_
+
+#include <cstddef>
+#include <cassert>
+#include <new>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+#include <boost/type_traits/aligned_storage.hpp>
+#include <boost/type_traits/alignment_of.hpp>
+
+template < typename T >
+/**
+ * @class NodePool
+ *
+ * Slab allocator for objects of a single type (i.e. octree nodes). Memory is
+ * requested to the system in chunks of #CHUNK_SIZE slots; released slots
+ * are kept in a free list and handed out again by next allocations.
+ * Chunks are given back to the system only when the pool is destroyed, so
+ * the owner has to destroy any object still alive before that moment.
+ *
+ * The pool is not thread safe: concurrent threads should use a pool each.
+ * An object can be destroyed by a pool other than the one that allocated
+ * it, as long as the latter outlives the former's free list.
+ */
+class NodePool : boost::noncopyable {
+
+private:
+	static const std::size_t CHUNK_SIZE = 4096;
+
+	union Slot {
+		Slot *next;
+		typename boost::aligned_storage< sizeof(T),
+				boost::alignment_of< T >::value >::type storage;
+	};
+
+private:
+	std::vector< Slot * > chunks;
+	Slot *freeList;
+
+	/** number of slots already handed out from the last chunk */
+	std::size_t lastChunkUsed;
+
+public:
+	/**
+	 * constructor: no memory is allocated until first #allocate call
+	 */
+	NodePool() :
+		freeList(NULL), lastChunkUsed(CHUNK_SIZE)
+	{ }
+
+	/**
+	 * destructor: releases all chunks in bulk without calling any
+	 * destructor on objects still living there
+	 */
+	virtual ~NodePool() {
+		for (std::size_t i = 0; i < chunks.size(); ++i) {
+			::operator delete(chunks[i]);
+		}
+	}
+
+	/**
+	 *
+	 * @return raw memory big enough to hold a T object: use it
+	 * with placement new
+	 */
+	void * allocate() {
+		Slot *slot;
+
+		if (freeList != NULL) {
+			slot = freeList;
+			freeList = slot->next;
+		} else {
+			if (lastChunkUsed == CHUNK_SIZE) {
+				chunks.push_back(static_cast< Slot * >(
+						::operator new(CHUNK_SIZE * sizeof(Slot))));
+				lastChunkUsed = 0;
+			}
+
+			slot = chunks.back() + lastChunkUsed++;
+		}
+
+		return slot;
+	}
+
+	/**
+	 * calls destructor on given object and puts its memory in the free list
+	 * @param obj an object built upon memory returned by #allocate
+	 */
+	void destroy(T *obj) {
+		assert(obj != NULL);
+
+		obj->~T();
+
+		Slot *slot = reinterpret_cast< Slot * >(obj);
+		slot->next = freeList;
+		freeList = slot;
+	}
+
+	/**
+	 *
+	 * @return number of objects this pool can hold without asking more
+	 * memory to the system
+	 */
+	std::size_t capacity() const {
+		return chunks.size() * CHUNK_SIZE;
+	}
+};
+
+#endif /* NODEPOOL_HPP_ */
@@ -16,8 +16,8 @@
 #include <boost/shared_ptr.hpp>
 #include <boost/make_shared.hpp>
 #include <boost/array.hpp>
-#include <boost/thread.hpp>
 #include <boost/ptr_container/ptr_deque.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
 #include <boost/assign/ptr_list_inserter.hpp>
 #include <boost/math/special_functions.hpp>
 #include <boost/function.hpp>
@@ -25,11 +25,23 @@
 #include <Eigen/Geometry>
 
 #include "octree_nodes.hpp"
+#include "ShiftedBox.hpp"
+#include "MortonCode.hpp"
+#include "NodePool.hpp"
+#include "SharedPool.hpp"
 
 /**
  * @class Octree
  *
- * defines an octree and the operations it can perform
+ * defines an octree and the operations it can perform. Nodes are allocated
+ * from pools (one for branches, one for leaves and one for their data) so
+ * that deleted nodes are recycled by next pushes and all the memory is
+ * released in bulk when the tree is destroyed. Every worker changing the tree has its own pools,
+ * so that concurrent changes never wait for each other.
+ *
+ * Nodes do not store their geometry: boxes are rebuilt on request from node
+ * locational code and depth using the per-depth cell sizes computed once by
+ * the tree.
  */
 class Octree {
 	
@@ -42,9 +54,45 @@ public:
 	
 	typedef OctreeNode::VersionInfo VersionInfo;
 	
+	/**
+	 * disjoint subtrees can be modified by different workers at the same
+	 * time: the only change they make to their common ancestors is to
+	 * their children masks, that are changed atomically (see
+	 * BranchNode::deleteChild)
+	 */
+	static const bool CONCURRENT_UPDATES = BranchNode::ATOMIC_CHILDREN;
+	
 private:
+	/**
+	 * pools of a worker: nodes released by a worker join its pools,
+	 * whichever pools allocated them. The data of the leaves is shared with
+	 * the mesher, so it goes back to the pool that allocated it, from
+	 * whichever thread releases it, and the pool outlives the tree until
+	 * all of it is released.
+	 */
+	struct NodePools {
+		NodePool< BranchNode > branches;
+		NodePool< LeafNode > leaves;
+		SharedPool *voxels;
+		VoxelInfo::Allocator voxelsAllocator;
+		
+		NodePools() : voxels(new SharedPool()), voxelsAllocator(voxels) { }
+		
+		~NodePools() {
+			voxels->retire();
+		}
+	};
+	
+private:
+	
+	typedef boost::array< Eigen::Vector3d, MortonCode::MAX_DEPTH + 1 > CellSizes;
 	
 	const Eigen::Vector3d EXTENT;
+	
+	/** size of the boxes of nodes at each depth */
+	CellSizes CELL_SIZES;
+	
+	boost::ptr_vector< NodePools > pools;
 	BranchPtr ROOT;
 	
 public:
@@ -52,34 +100,42 @@ public:
 	/**
 	 * constructor
 	 * @param extent
+	 * @param nWorkers number of workers that can change the tree at the
+	 * same time (see #pushLeaf)
 	 */
-	Octree(Eigen::Vector3d extent) :
+	Octree(Eigen::Vector3d extent, unsigned int nWorkers = 1) :
 			EXTENT(extent)
 	{
+		if (nWorkers == 0)
+			throw std::invalid_argument("workers number should be >0");
 		
 		GeometryUtils::checkExtent(EXTENT);
 		
+		CELL_SIZES[0] = EXTENT;
+		for (unsigned int d = 1; d < CELL_SIZES.size(); ++d) {
+			CELL_SIZES[d] = CELL_SIZES[d - 1] * 0.5;
+		}
+		
+		for (unsigned int i = 0; i < nWorkers; ++i) {
+			pools.push_back(new NodePools());
+		}
+		
+		
 		/* create a FAKE root, link it with the leaves list and then "push"
 		 * it to get a branch (REAL root) and it's first children level
 		 */
 		VersionInfo fakeVinfo(1, 1);
 		
-		ShiftedBox::Ptr initialBox(new ShiftedBox(
-				Eigen::Vector3d::Zero(),
-				EXTENT
-		));
-		
-		boost::shared_ptr< LeafNode > fakeRoot = boost::make_shared< LeafNode >(
-				initialBox, fakeVinfo);
+		LeafNode fakeRoot(fakeVinfo);
 		
-		ROOT = createLevel(fakeRoot.get(), fakeVinfo);
+		ROOT = createLevel(&fakeRoot, fakeVinfo, pools.front());
 	}
 	
 	/**
 	 * destructor
 	 */
 	virtual ~Octree() {
-		delete ROOT;
+		releaseNode(ROOT, pools.front());
 	}
 	
 	
@@ -92,45 +148,89 @@ public:
 		return ROOT;
 	}
 	
+	/**
+	 * fills the given box with the geometry of the node
+	 *
+	 * @param node
+	 * @param box output box, expressed in model basis (origin in the
+	 * center of the root box)
+	 */
+	void getBox(const OctreeNode::ConstPtr &node, ShiftedBox &box) const {
+		unsigned int depth = node->getDepth();
+		assert(depth < CELL_SIZES.size());
+		
+		boost::uint32_t coords[3];
+		MortonCode::decode(node->getCode(), depth, coords);
+		
+		const Eigen::Vector3d &cell = CELL_SIZES[depth];
+		ShiftedBox::MinMaxMatrix &minMax = box.getMatrix();
+		for (int a = 0; a < 3; ++a) {
+			minMax(a, ShiftedBox::MIN_IDX) = coords[a] * cell[a] - EXTENT[a] * 0.5;
+			minMax(a, ShiftedBox::MAX_IDX) = (coords[a] + 1) * cell[a] - EXTENT[a] * 0.5;
+		}
+		
+		box.calculateExtentsAndVolume();
+	}
+	
+	/**
+	 *
+	 * @param node
+	 * @return a newly allocated box with the geometry of the node
+	 */
+	ShiftedBox::Ptr buildBox(const OctreeNode::ConstPtr &node) const {
+		ShiftedBox::Ptr box = boost::allocate_shared< ShiftedBox >(
+				Eigen::aligned_allocator< ShiftedBox >());
+		getBox(node, *box);
+		
+		return box;
+	}
+	
 	/**
 	 * updates the content of a leaf
 	 * @param lpt
 	 * @param vinfo
+	 * @return \c true if it is the first change of the leaf in the
+	 * current version
 	 */
-	void updateData(LeafPtr lpt, const VersionInfo &vinfo) {
-		lpt->setFirstChangeVersion(vinfo);
+	bool updateData(LeafPtr lpt, const VersionInfo &vinfo) {
+		return lpt->setFirstChangeVersion(vinfo);
 	}
 	
 	/**
 	 * deletes selected leaf
 	 * @param lpt
+	 * @param worker index of the calling worker (see #pushLeaf)
 	 */
-	void deleteLeaf(LeafPtr &lpt) {
-		deleteNode(lpt);
+	void deleteLeaf(LeafPtr lpt, unsigned int worker = 0) {
+		deleteNode(lpt, pools[worker]);
 	}
 	
 	/**
 	 * deletes a whole branch of the octree
 	 *
 	 * @param bpt
+	 * @param worker index of the calling worker (see #pushLeaf)
 	 */
-	void deleteBranch(BranchPtr &bpt) {
+	void deleteBranch(BranchPtr bpt, unsigned int worker = 0) {
 		// I have to signal nothing when an internal node is deleted
-		deleteNode(bpt);
+		deleteNode(bpt, pools[worker]);
 	}
 	
 	/**
 	 * expands a leaf into 8 branches
 	 *
-	 * @param lpt
+	 * @param lpt leaf to push: it is no longer valid after the call
 	 * @param vinfo
-	 * @return
+	 * @param worker index of the calling worker, lower than the number of
+	 * workers given to the constructor: workers changing the tree at the
+	 * same time must have different indices
+	 * @return the branch that replaced the leaf
 	 */
-	BranchNode::Ptr pushLeaf(LeafPtr &lpt, const VersionInfo &vinfo) {
+	BranchPtr pushLeaf(LeafPtr lpt, const VersionInfo &vinfo, unsigned int worker = 0) {
 		
-		lpt->getFather()->setFirstChangeVersion(vinfo);
+		NodePools &workerPools = pools[worker];
 		
-		BranchPtr newBranch = createLevel(lpt, vinfo);
+		BranchPtr newBranch = createLevel(lpt, vinfo, workerPools);
 		
 		// now attach branch to the tree
 		BranchNode::Ptr father = static_cast< BranchNode::Ptr >(lpt->getFather());
@@ -144,26 +244,86 @@ public:
 		// then set newBranch as father's child
 		father->setChild(leafIdx, newBranch);
 		
-		// then free leaf's memory (no longer needed)
-		delete lpt; lpt = NULL;
+		// then give leaf's memory back to the pool (no longer needed)
+		workerPools.leaves.destroy(lpt);
 		
 		return newBranch;
 	}
 	
+	/**
+	 * collapses a branch whose children are all leaves into a single leaf
+	 * with no inside corner
+	 *
+	 * @param bpt branch to merge: it is no longer valid after the call
+	 * @param vinfo
+	 * @param worker index of the calling worker (see #pushLeaf)
+	 * @return the leaf that replaced the branch
+	 */
+	LeafPtr mergeBranch(BranchPtr bpt, const VersionInfo &vinfo, unsigned int worker = 0) {
+		
+		assert(!bpt->isRoot());
+		NodePools &workerPools = pools[worker];
+		
+		BranchNode::Ptr father = static_cast< BranchNode::Ptr >(bpt->getFather());
+		unsigned char branchIdx = bpt->getChildIdx();
+		
+		LeafPtr newLeaf = new (workerPools.leaves.allocate()) LeafNode(father, branchIdx, vinfo,
+				workerPools.voxelsAllocator);
+		
+		// replace the branch in its father...
+		father->deleteChild(branchIdx);
+		father->setChild(branchIdx, newLeaf);
+		
+		// ...then give the memory of the branch and its leaves back to the pools
+		releaseNode(bpt, workerPools);
+		
+		return newLeaf;
+	}
+	
 private:
 	
 	/**
 	 * deletes a generic node, plus all of its children, if any
 	 *
 	 * @param node
+	 * @param workerPools pools of the calling worker
 	 */
-	void deleteNode(OctreeNode::Ptr node) {
+	void deleteNode(OctreeNode::Ptr node, NodePools &workerPools) {
 		// tells father to forget its children
 		BranchNode::Ptr bnp = static_cast< BranchNode::Ptr >(node->getFather());
 		bnp->deleteChild(node->getChildIdx());
 		
-		// then free leaf's memory (no longer needed)
-		delete node;
+		// then free node's memory (no longer needed)
+		releaseNode(node, workerPools);
+	}
+	
+	/**
+	 * gives the memory of the node, and of all of its children if any, back
+	 * to the pools. Node is not detached from its father.
+	 *
+	 * @param node
+	 * @param workerPools pools of the calling worker
+	 */
+	void releaseNode(OctreeNode::Ptr node, NodePools &workerPools) {
+		switch (node->getType()) {
+			case OctreeNode::BRANCH_NODE: {
+				BranchNode::Ptr branch = static_cast< BranchNode::Ptr >(node);
+				for (int i = 0; i < BranchNode::N_CHILDREN; ++i) {
+					if (branch->hasChild(i)) {
+						releaseNode(branch->getChild(i), workerPools);
+					}
+				}
+				workerPools.branches.destroy(branch);
+				break;
+			}
+			
+			case OctreeNode::LEAF_NODE:
+				workerPools.leaves.destroy(static_cast< LeafNode::Ptr >(node));
+				break;
+				
+			default:
+				throw std::runtime_error("Unknown node type");
+		}
 	}
 	
 	/**
@@ -176,61 +336,38 @@ private:
 	 * \li main tree isolation that is it will not modify main tree links, so
 	 * it is not reachable from it.
 	 * @param leaf
+	 * @param vinfo
+	 * @param workerPools pools of the calling worker
 	 * @return
 	 */
-	BranchPtr createLevel(const LeafConstPtr &leaf, const VersionInfo &vinfo) const {
+	BranchPtr createLevel(const LeafConstPtr &leaf, const VersionInfo &vinfo, NodePools &workerPools) {
+		
+		if (leaf->getDepth() >= MortonCode::MAX_DEPTH) {
+			throw std::invalid_argument("Given leaf is too deep to be pushed");
+		}
 		
 		BranchPtr newBranch;
 		// first create new branch node that will replace given leaf
 		if (leaf->isRoot()) {
-			newBranch = new BranchNode(leaf->getBox(), vinfo);
+			newBranch = new (workerPools.branches.allocate()) BranchNode(vinfo);
 		} else {
-			newBranch = new BranchNode(leaf->getFather(),
+			newBranch = new (workerPools.branches.allocate()) BranchNode(leaf->getFather(),
 				leaf->getChildIdx(),
-				leaf->getBox(),
 				vinfo);
 		}
 		
-		// create some variables needed in the following leaves-generation loop
-		
-		/* we have to create new shift boxes for each child
-		 * thanks to "OpenSceneGraph3 Cookbook" for the if-free code
+		/* children geometry is implicit in their code: child index bits
+		 * select the X (bit 2), Y (bit 1) and Z (bit 0) half of the father
 		 */
-		int s[3];
-		Eigen::Vector3d extentSet[3] = {
-			leaf->getBox()->getMin(),
-			leaf->getBox()->getShift(),
-			leaf->getBox()->getMax()
-		};
-		int childIdx = 0;
-		
-		for ( s[0]=0; s[0]<2; ++s[0] ) {
-			for ( s[1]=0; s[1]<2; ++s[1] ) {
-				for ( s[2]=0; s[2]<2; ++s[2] ) {
-					
-					// create shifted box for the child
-					ShiftedBox::Ptr newBox(new ShiftedBox());
-					ShiftedBox::MinMaxMatrix &minMax = newBox->getMatrix();
-					
-					for ( int a=0; a<3; ++a ) {
-						minMax(a, ShiftedBox::MIN_IDX) = (extentSet[s[a] + 0])[a]; // min
-						minMax(a, ShiftedBox::MAX_IDX) = (extentSet[s[a] + 1])[a]; // max
-					}
-					
-					newBox->calculateExtentsAndVolume();
-					
-					// build child idx
-					LeafPtr child = new LeafNode(
-							newBranch,
-							childIdx,
-							newBox,
-							vinfo);
-					
-					newBranch->setChild(childIdx, child);
-					
-					childIdx++;
-				}
-			}
+		for (int childIdx = 0; childIdx < BranchNode::N_CHILDREN; ++childIdx) {
+			LeafPtr child = new (workerPools.leaves.allocate()) LeafNode(
+					newBranch,
+					childIdx,
+					vinfo,
+					*leaf->getData(),
+					workerPools.voxelsAllocator);
+			
+			newBranch->setChild(childIdx, child);
 		}
 		
 		return newBranch;
@@ -0,0 +1,87 @@
+/**
+ * PtrHandoff.hpp
+ *
+ *  Created on: 17/ott/2026
+ *      Author: socket
+ */
+
+#ifndef PTRHANDOFF_HPP_
+#define PTRHANDOFF_HPP_
+
+#include <cassert>
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "common/AtomicNumber.hpp"
+
+template < typename DataT >
+/**
+ * @class PtrHandoff
+ *
+ * Lock-free single slot used to pass data from a producer thread to a
+ * consumer one. The consumer takes the slot content and then requests a
+ * new one; the producer publishes new data only when a request is pending
+ * and the slot is empty, so neither thread ever waits for the other.
+ * Published data is owned by the slot until it is taken.
+ */
+class PtrHandoff : boost::noncopyable {
+
+public:
+	typedef boost::shared_ptr< DataT > Ptr;
+
+private:
+	AtomicNumber< DataT *, AtomicOrder::ACQ_REL > published;
+	AtomicNumber< int, AtomicOrder::ACQ_REL > requested;
+
+public:
+	PtrHandoff() : published(NULL), requested(0) { }
+
+	virtual ~PtrHandoff() {
+		delete published.set(NULL);
+	}
+
+	/**
+	 * producer side
+	 *
+	 * @return true if the consumer is waiting for new data
+	 */
+	bool isRequested() const {
+		/* only the producer fills the slot, so once seen empty it remains
+		 * empty until #publish is called
+		 */
+		return requested.get() && (published.get() == NULL);
+	}
+
+	/**
+	 * producer side: must be called only if #isRequested
+	 *
+	 * @param data new data, whose ownership is passed to the slot
+	 */
+	void publish(DataT *data) {
+		assert(isRequested());
+
+		requested.set(0);
+		DataT *old = published.set(data);
+		assert(old == NULL);
+		(void)old;
+	}
+
+	/**
+	 * consumer side
+	 *
+	 * @return published data (empty pointer if none)
+	 */
+	Ptr take() {
+		return Ptr(published.set(NULL));
+	}
+
+	/**
+	 * consumer side: asks the producer for new data
+	 */
+	void request() {
+		requested.set(1);
+	}
+};
+
+#endif /* PTRHANDOFF_HPP_ */
@@ -0,0 +1,300 @@
+/**
+ * SharedPool.hpp
+ *
+ *  Created on: 17/ott/2026
+ *      Author: socket
+ */
+
+#ifndef SHAREDPOOL_HPP_
+#define SHAREDPOOL_HPP_
+
+#include <cstddef>
+#include <cassert>
+#include <climits>
+#include <new>
+#include <vector>
+#include <algorithm>
+
+#include <boost/noncopyable.hpp>
+#include <boost/type_traits/alignment_of.hpp>
+
+#include "common/AtomicNumber.hpp"
+
+#if !defined(__GNUC__) || !defined(__ATOMIC_SEQ_CST)
+#include <boost/thread.hpp>
+#endif
+
+/**
+ * @class SharedPool
+ *
+ * Slab allocator for objects of a single size that are released by other
+ * threads too (i.e. the data of the leaves, shared with the mesher). Only
+ * one thread at a time can allocate from the pool, without any lock, while
+ * any thread can release a slot: released slots are pushed on a lock-free
+ * list that the allocating thread takes in one go once its own free list
+ * is exhausted.
+ *
+ * The pool is created on the heap by its owner, that gives it up with
+ * #retire: it is destroyed, releasing its chunks, only once the owner has
+ * retired it and all of its slots have been released.
+ */
+class SharedPool : boost::noncopyable {
+
+private:
+	static const std::size_t CHUNK_SIZE = 4096;
+
+	/** alignment of the slots, the one of the memory of the chunks */
+	static const std::size_t ALIGNMENT = 2 * sizeof(void *);
+	
+	/**
+	 * keeps the references above 0 until the pool is retired, so that
+	 * allocations need not change them atomically
+	 */
+	static const long REFERENCES_BIAS = LONG_MAX / 2;
+
+	struct Slot {
+		Slot *next;
+	};
+
+private:
+	std::vector< char * > chunks;
+
+	/** size of the slots, fixed by the first allocation */
+	std::size_t slotSize;
+
+	/** number of slots already handed out from the last chunk */
+	std::size_t lastChunkUsed;
+
+	/** released slots that only the allocating thread reaches */
+	Slot *freeList;
+
+	/** slots released by any thread since the last allocation that took them */
+	Slot *releasedList;
+
+	/** slots handed out so far, only the allocating thread changes it */
+	long allocated;
+	
+	/**
+	 * REFERENCES_BIAS minus the released slots until the owner retires the
+	 * pool, when the slots still allocated: the pool is destroyed when it
+	 * drops to 0
+	 */
+	AtomicNumber< long, AtomicOrder::ACQ_REL > references;
+
+#if !defined(__GNUC__) || !defined(__ATOMIC_SEQ_CST)
+	boost::mutex releasedMutex;
+#endif
+
+public:
+	/**
+	 * constructor: no memory is allocated until first #allocate call
+	 */
+	SharedPool() :
+		slotSize(0), lastChunkUsed(CHUNK_SIZE), freeList(NULL),
+		releasedList(NULL), allocated(0), references(REFERENCES_BIAS)
+	{ }
+
+	/**
+	 * gives up the pool: it is destroyed as soon as all of its slots are
+	 * released, right now if none is allocated. It must be called once, by
+	 * the owner, that cannot allocate from the pool any more.
+	 */
+	void retire() {
+		if (references.addAndGet(allocated - REFERENCES_BIAS) == 0) {
+			delete this;
+		}
+	}
+
+	/**
+	 * it must be called by one thread at a time
+	 *
+	 * @param size size of the object to allocate: it must be the same at
+	 * every call
+	 * @return raw memory big enough to hold the object, aligned as any
+	 * fundamental type: use it with placement new
+	 */
+	void * allocate(std::size_t size) {
+		if (slotSize == 0) {
+			slotSize = (std::max(size, sizeof(Slot)) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+		}
+		assert(size <= slotSize);
+
+		if (freeList == NULL) {
+			freeList = takeReleased();
+		}
+
+		Slot *slot;
+		if (freeList != NULL) {
+			slot = freeList;
+			freeList = slot->next;
+		} else {
+			if (lastChunkUsed == CHUNK_SIZE) {
+				chunks.push_back(static_cast< char * >(
+						::operator new(CHUNK_SIZE * slotSize)));
+				lastChunkUsed = 0;
+			}
+
+			slot = reinterpret_cast< Slot * >(chunks.back() + slotSize * lastChunkUsed++);
+		}
+
+		++allocated;
+		return slot;
+	}
+
+	/**
+	 * gives a slot back to the pool: it can be called by any thread
+	 *
+	 * @param p memory returned by #allocate, whose object has already been
+	 * destroyed
+	 */
+	void release(void *p) {
+		assert(p != NULL);
+
+		Slot *slot = static_cast< Slot * >(p);
+#if defined(__GNUC__) && defined(__ATOMIC_SEQ_CST)
+		/* only the allocating thread takes slots from the list, and it
+		 * takes all of them, so a slot cannot come back to the head while
+		 * it is being pushed
+		 */
+		slot->next = __atomic_load_n(&releasedList, __ATOMIC_RELAXED);
+		while (!__atomic_compare_exchange_n(&releasedList, &slot->next, slot,
+				true, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) { }
+#else
+		{
+			boost::lock_guard< boost::mutex > l(releasedMutex);
+			slot->next = releasedList;
+			releasedList = slot;
+		}
+#endif
+
+		if (references.decAndGet() == 0) {
+			delete this;
+		}
+	}
+
+	/**
+	 *
+	 * @return number of slots this pool can hold without asking more
+	 * memory to the system
+	 */
+	std::size_t capacity() const {
+		return chunks.size() * CHUNK_SIZE;
+	}
+
+private:
+	/**
+	 * destructor: releases all chunks in bulk (see #retire)
+	 */
+	virtual ~SharedPool() {
+		for (std::size_t i = 0; i < chunks.size(); ++i) {
+			::operator delete(chunks[i]);
+		}
+	}
+
+	/**
+	 *
+	 * @return the slots released so far, the list is emptied
+	 */
+	Slot * takeReleased() {
+#if defined(__GNUC__) && defined(__ATOMIC_SEQ_CST)
+		// plain read first: most of the times nothing has been released
+		if (__atomic_load_n(&releasedList, __ATOMIC_RELAXED) == NULL) {
+			return NULL;
+		}
+		return __atomic_exchange_n(&releasedList, (Slot *)NULL, __ATOMIC_ACQUIRE);
+#else
+		boost::lock_guard< boost::mutex > l(releasedMutex);
+		Slot *released = releasedList;
+		releasedList = NULL;
+		return released;
+#endif
+	}
+};
+
+template < typename T >
+/**
+ * @class PoolAllocator
+ *
+ * Standard allocator of single objects upon a SharedPool, i.e. for
+ * boost::allocate_shared: the shared pointer keeps a copy of the allocator,
+ * so its object is given back to the pool by whichever thread releases it.
+ * Copies refer to the same pool, that must not be retired while it is
+ * still used to allocate.
+ */
+class PoolAllocator {
+
+	template < typename U > friend class PoolAllocator;
+
+public:
+	typedef T value_type;
+	typedef T * pointer;
+	typedef const T * const_pointer;
+	typedef T & reference;
+	typedef const T & const_reference;
+	typedef std::size_t size_type;
+	typedef std::ptrdiff_t difference_type;
+
+	template < typename U >
+	struct rebind {
+		typedef PoolAllocator< U > other;
+	};
+
+private:
+	SharedPool *pool;
+
+public:
+	/**
+	 * constructor
+	 * @param pool
+	 */
+	explicit PoolAllocator(SharedPool *pool) : pool(pool) { }
+
+	/**
+	 * copy constructor for another type
+	 * @param other
+	 */
+	template < typename U >
+	PoolAllocator(const PoolAllocator< U > &other) : pool(other.pool) { }
+
+	pointer address(reference x) const { return &x; }
+	const_pointer address(const_reference x) const { return &x; }
+
+	/**
+	 *
+	 * @param n it must be 1
+	 * @return memory for an object
+	 */
+	pointer allocate(size_type n, const void * = 0) {
+		assert(n == 1);
+		assert(boost::alignment_of< T >::value <= 2 * sizeof(void *));
+		return static_cast< pointer >(pool->allocate(n * sizeof(T)));
+	}
+
+	void deallocate(pointer p, size_type) {
+		pool->release(p);
+	}
+
+	size_type max_size() const {
+		return 1;
+	}
+
+	void construct(pointer p, const T &val) {
+		new (p) T(val);
+	}
+
+	void destroy(pointer p) {
+		p->~T();
+	}
+
+	template < typename U >
+	bool operator==(const PoolAllocator< U > &other) const {
+		return pool == other.pool;
+	}
+
+	template < typename U >
+	bool operator!=(const PoolAllocator< U > &other) const {
+		return pool != other.pool;
+	}
+};
+
+#endif /* SHAREDPOOL_HPP_ */
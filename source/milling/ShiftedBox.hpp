@@ -19,6 +19,7 @@
 
 #include <osg/BoundingBox>
 
+#include "common/SimdDouble.hpp"
 #include "Corner.hpp"
 
 /**
@@ -43,6 +44,19 @@ public:
 	static const int MIN_IDX = 0;
 	static const int MAX_IDX = 1;
 	
+	/**
+	 * sums of the radii of two boxes projected on each of the 15
+	 * potential separating axes: the 3 axes of this box, the 3 axes of
+	 * the other one and their 9 cross products. They depend only on the
+	 * extents of the boxes and on their relative rotation (see
+	 * #calculateSeparatingRadii)
+	 */
+	struct SeparatingRadii {
+		static const int N_AXES = 15;
+		
+		double radii[N_AXES];
+	};
+	
 private:
 	
 	MinMaxMatrix MIN_MAX;
@@ -163,6 +177,63 @@ public:
 		return rototras * getCorner(corner);
 	}
 	
+	/**
+	 * rototraslates all the corners at once, performing the same operations
+	 * of #getCorner(const Corner::CornerType &, const Eigen::Isometry3d &)
+	 *
+	 * @param rototras
+	 * @param corners output corners, rototraslated according to the given
+	 * rototraslation
+	 */
+	inline
+	void getCorners(const Eigen::Isometry3d &rototras, CornerCoords &corners) const {
+		const double minX = MIN_MAX(0, MIN_IDX), maxX = MIN_MAX(0, MAX_IDX);
+		const double minY = MIN_MAX(1, MIN_IDX), maxY = MIN_MAX(1, MAX_IDX);
+		const double minZ = MIN_MAX(2, MIN_IDX), maxZ = MIN_MAX(2, MAX_IDX);
+		
+		// see Corner::CornerType
+		const CornerCoords box = { 
+			{ minX, maxX, maxX, minX, minX, maxX, maxX, minX },
+			{ minY, minY, maxY, maxY, minY, minY, maxY, maxY },
+			{ minZ, minZ, minZ, minZ, maxZ, maxZ, maxZ, maxZ }
+		};
+		
+		transformCorners(box, rototras, corners);
+	}
+	
+	/**
+	 * rototraslates a set of points, performing the same operations of
+	 * Eigen isometry product
+	 *
+	 * @param points
+	 * @param rototras
+	 * @param result output points
+	 */
+	inline
+	static void transformCorners(const CornerCoords &points, const Eigen::Isometry3d &rototras,
+			CornerCoords &result) {
+		typedef SimdDouble SD;
+		
+		const Eigen::Matrix4d &m = rototras.matrix();
+		double *out[3] = { result.x, result.y, result.z };
+		
+		for (int c = 0; c < Corner::N_CORNERS; c += SD::WIDTH) {
+			SD::Vector x = SD::load(points.x + c);
+			SD::Vector y = SD::load(points.y + c);
+			SD::Vector z = SD::load(points.z + c);
+			
+			// same operations order of Eigen isometry product
+			for (int r = 0; r < 3; ++r) {
+				SD::Vector res = SD::mul(SD::set(m(r, 0)), x);
+				res = SD::add(res, SD::mul(SD::set(m(r, 1)), y));
+				res = SD::add(res, SD::mul(SD::set(m(r, 2)), z));
+				res = SD::add(res, SD::set(m(r, 3)));
+				
+				SD::store(out[r] + c, res);
+			}
+		}
+	}
+	
 	/**
 	 *
 	 * @param corner
@@ -219,6 +290,28 @@ public:
 		return true;
 	}
 	
+	/**
+	 *
+	 * @param minMax
+	 * @return True if given matrix lies entirely inside the box
+	 */
+	bool isContaining(const MinMaxMatrix &minMax) const {
+		const MinMaxMatrix &thisMM = getMatrix();
+		
+		for (int i = 0; i < 3; ++i) {
+			
+			if(minMax(i, MIN_IDX) < thisMM(i, MIN_IDX)
+				||
+				minMax(i, MAX_IDX) > thisMM(i, MAX_IDX)) {
+				
+				return false;
+			}
+			
+		}
+		
+		return true;
+	}
+	
 	/**
 	 *	Use the separating axis test for all 15 potential
 	 *	separating axes. If a separating axis could not be found, the two
@@ -349,6 +442,100 @@ public:
 		return true;
 	}
 	
+	/**
+	 * performs the same separating axis test of
+	 * #isIntersecting(const Eigen::Vector3d &, const Eigen::Isometry3d &, bool)
+	 * with the radii already projected on the axes, so that only the
+	 * distance between the boxes has to be projected
+	 *
+	 * @param rototras
+	 * @param radii radii of a box as big as this one and of the other box
+	 * @param accurate see #isIntersecting(const Eigen::Vector3d &, const Eigen::Isometry3d &, bool)
+	 * @return True if the other box intersects the box
+	 */
+	bool isIntersecting(const Eigen::Isometry3d &rototras,
+			const SeparatingRadii &radii,
+			bool accurate) const {
+		
+		const double *r = radii.radii;
+		const Eigen::Matrix3d &rotation = rototras.linear();
+		const Eigen::Vector3d traslation = rototras.translation() - 
+				this->getShift();
+		
+		//A's basis vectors
+		for(int i = 0; i < 3; i++ ) {
+			if( fabs(traslation[i]) > r[i] )
+				return false;
+		}
+		
+		//B's basis vectors
+		for(int i = 0; i < 3; i++ ) {
+			double t = fabs((
+					traslation[0] * rotation(0, i)
+					+ traslation[1] * rotation(1, i)
+					+ traslation[2] * rotation(2, i)
+			));
+			if( t > r[3 + i] )
+				return false;
+		}
+		
+		if (accurate) {
+			//9 cross products, Ai x Bj
+			for(int i = 0; i < 3; i++ ) {
+				const int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+				for(int j = 0; j < 3; j++ ) {
+					double t = fabs(traslation[i2]*rotation(i1, j) - traslation[i1]*rotation(i2, j));
+					if( t > r[6 + 3 * i + j] )
+						return false;
+				}
+			}
+		}
+		
+		return true;
+	}
+	
+	/**
+	 * projects the radii of two boxes on the potential separating axes
+	 *
+	 * @param extents extents of the first box
+	 * @param otherExtents extents of the other box
+	 * @param rotation rotation of the other box, relative to the first one
+	 * @param radii output radii
+	 */
+	static void calculateSeparatingRadii(const Eigen::Vector3d &extents,
+			const Eigen::Vector3d &otherExtents,
+			const Eigen::Matrix3d &rotation,
+			SeparatingRadii &radii) {
+		
+		const Eigen::Vector3d a = extents * 0.5,
+				b = otherExtents * 0.5;
+		double *r = radii.radii;
+		
+		//A's basis vectors
+		for(int i = 0; i < 3; i++ ) {
+			r[i] = a[i] + (b[0] * fabs(rotation(i, 0)) 
+					+ b[1] * fabs(rotation(i, 1)) 
+					+ b[2] * fabs(rotation(i, 2)));
+		}
+		
+		//B's basis vectors
+		for(int i = 0; i < 3; i++ ) {
+			r[3 + i] = (a[0] * fabs(rotation(0, i))
+					+ a[1] * fabs(rotation(1, i))
+					+ a[2] * fabs(rotation(2, i))) + b[i];
+		}
+		
+		//9 cross products, Ai x Bj
+		for(int i = 0; i < 3; i++ ) {
+			const int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+			for(int j = 0; j < 3; j++ ) {
+				const int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+				r[6 + 3 * i + j] = (a[i1]*fabs(rotation(i2, j)) + a[i2]*fabs(rotation(i1, j)))
+						+ (b[j1]*fabs(rotation(i, j2)) + b[j2]*fabs(rotation(i, j1)));
+			}
+		}
+	}
+	
 //	friend std::ostream & operator<<(std::ostream &os, const ShiftedBox &sbox) {
 //		os << "SBOX[" << *sbox.simpleBox << "@(" 
 //				<< sbox.shift.translation().transpose() << ")]";
@@ -13,10 +13,13 @@
 #include <deque>
 #include <stdexcept>
 #include <cmath>
+#include <limits>
 
 #include <boost/utility.hpp>
 #include <boost/chrono.hpp>
 #include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <boost/array.hpp>
 #include <boost/ptr_container/ptr_vector.hpp>
 #include <boost/assign/ptr_list_inserter.hpp>
 
@@ -26,30 +29,96 @@
 
 #include "Corner.hpp"
 #include "StoredData.hpp"
+#include "SweptCutter.hpp"
 
-Stock::Stock(const StockDescription &desc, unsigned int maxDepth, MesherType::Ptr mesher) :
+const int Stock::AUTO_DEPTH_SWITCH;
+
+Stock::Stock(const StockDescription &desc, unsigned int maxDepth, MesherType::Ptr mesher,
+		unsigned int nThreads, int depthSwitch) :
 	MAX_DEPTH(maxDepth),
 	EXTENT(desc.getGeometry()->asEigen()),
 	STOCK_MODEL_TRASLATION(EXTENT / 2.0),
-	MODEL(EXTENT), intersectionTester(maxDepth),
-	MESHER(mesher), lastRetrievedVersion(0), versioner(2)
+	intersectionTester(EXTENT, maxDepth, (depthSwitch < 0) ? std::min(4u, maxDepth) : depthSwitch),
+	depthSwitchProfiler(maxDepth, depthSwitch < 0),
+	MESHER(mesher), lastRetrievedVersion(0), versioner(2), SPLIT_DEPTH(0),
+	descentStart(MortonCode::ROOT),
+	compactMin(Eigen::Vector3d::Constant(-std::numeric_limits< double >::infinity())),
+	compactMax(Eigen::Vector3d::Constant(std::numeric_limits< double >::infinity()))
 {
 	GeometryUtils::checkExtent(EXTENT);
 	if(MAX_DEPTH <= 0)
 		throw std::invalid_argument("max depth should be >0");
+	if(MAX_DEPTH > MortonCode::MAX_DEPTH)
+		throw std::invalid_argument("max depth is too big");
+	if(nThreads <= 0)
+		throw std::invalid_argument("thread number should be >0");
 	
-	PROCESSERS[OctreeNode::BRANCH_NODE] = &Stock::processTreeRecursive;
-	PROCESSERS[OctreeNode::LEAF_NODE] = &Stock::analyzeLeaf;
+	if (nThreads > 1) {
+		POOL.reset(new WorkStealingPool(nThreads));
+		
+		/* split until there are at least 4 subtrees per thread so that
+		 * stealing can balance subtrees that do not touch the cutter
+		 */
+		unsigned int nSubtrees = 1;
+		while (nSubtrees < 4 * nThreads && SPLIT_DEPTH < MAX_DEPTH) {
+			nSubtrees *= BranchNode::N_CHILDREN;
+			SPLIT_DEPTH++;
+		}
+	}
+	
+	MODEL.reset(new OctreeType(EXTENT, nThreads));
 }
 
-Stock::~Stock() { }
+Stock::~Stock() {
+	// a snapshot being written must not reach the model any more
+	completeSnapshot();
+}
 
 IntersectionResult Stock::intersect(const Cutter::ConstPtr &cutter,
 		const Eigen::Isometry3d &rototras) {
 	
-	boost::chrono::thread_clock::time_point startTime = boost::chrono::thread_clock::now();
+	PoseList rototrasls(1, rototras);
+	return intersect(CutterList(1, cutter), rototrasls).front();
+}
+
+Stock::ResultList Stock::intersect(const Cutter::ConstPtr &cutter,
+		const PoseList &rototrasls) {
 	
-	Cutter::BoundingBoxInfo bboxInfo = cutter->getBoundingBox();
+	return intersect(CutterList(rototrasls.size(), cutter), rototrasls);
+}
+
+IntersectionResult Stock::intersect(const Cutter::ConstPtr &cutter,
+		const Eigen::Isometry3d &from, const Eigen::Isometry3d &to) {
+	
+	PoseList rototrasls(1, from);
+	return intersect(CutterList(1, SweptCutter::buildSegment(cutter, from, to)), rototrasls).front();
+}
+
+Stock::ResultList Stock::intersectPath(const Cutter::ConstPtr &cutter,
+		const Eigen::Isometry3d &start, const PoseList &rototrasls) {
+	
+	CutterList cutters;
+	PoseList segmentStarts;
+	for (unsigned int k = 0; k < rototrasls.size(); ++k) {
+		const Eigen::Isometry3d &from = (k == 0) ? start : rototrasls[k - 1];
+		
+		cutters.push_back(SweptCutter::buildSegment(cutter, from, rototrasls[k]));
+		segmentStarts.push_back(from);
+	}
+	
+	return intersect(cutters, segmentStarts);
+}
+
+Stock::ResultList Stock::intersect(const CutterList &cutters,
+		const PoseList &rototrasls) {
+	
+	if (rototrasls.empty() || rototrasls.size() > MAX_POSES)
+		throw std::invalid_argument("poses number should be in [1, MAX_POSES]");
+	assert(cutters.size() == rototrasls.size());
+	
+	Trace::Scope scope("Stock::intersect", "milling");
+	boost::chrono::thread_clock::time_point startTime = boost::chrono::thread_clock::now();
+	boost::chrono::steady_clock::time_point wallStartTime = boost::chrono::steady_clock::now();
 	
 	/* in order to find bbox isometry i can think about converting a bbox point
 	 * to a stock point: first the point should be converted bbox=>cutter basis
@@ -66,172 +135,612 @@ IntersectionResult Stock::intersect(const Cutter::ConstPtr &cutter,
 	 * 
 	 * Eigen::Isometry3d bboxIsom_model = STOCK_MODEL_TRASLATION.inverse() * bboxIsom_stock;
 	 * 
-	 * all summed up:
+	 * all summed up (for each pose):
 	 */
 	
-	Eigen::Isometry3d cutterIsom_model = STOCK_MODEL_TRASLATION.inverse() * rototras;
-	Eigen::Isometry3d bboxIsom_model = cutterIsom_model * bboxInfo.rototraslation;
+	if (depthSwitchProfiler.isProfiling()) {
+		intersectionTester.setDepthSwitch(depthSwitchProfiler.getCandidate());
+	}
 	
-	ShiftedBox::MinMaxMatrix cutterBboxMinMax;
-	ShiftedBox::calculateMinMax(cutterBboxMinMax, bboxIsom_model, bboxInfo.extents);
+	const unsigned int nPoses = rototrasls.size();
+	std::vector< Cutter::BoundingBoxInfo,
+		Eigen::aligned_allocator< Cutter::BoundingBoxInfo > > bboxInfos;
+	bboxInfos.reserve(nPoses);
+	PoseList cutterIsoms_model(nPoses), modelIsoms_cutter(nPoses), bboxIsoms_model(nPoses);
+	std::vector< ShiftedBox::MinMaxMatrix,
+		Eigen::aligned_allocator< ShiftedBox::MinMaxMatrix > > cutterBboxMinMaxs(nPoses);
+	ShiftedBox::MinMaxMatrix unionMinMax;
+	boost::ptr_vector< CutterInfos > cutterInfos;
 	
-	CutterInfos cutterInfo(cutter, &bboxInfo.extents, &cutterIsom_model, &bboxIsom_model,
-			&cutterBboxMinMax
-	);
-	
-	IntersectionResult results;
+	for (unsigned int k = 0; k < nPoses; ++k) {
+		bboxInfos.push_back(cutters[k]->getBoundingBox());
+		const Cutter::BoundingBoxInfo &bboxInfo = bboxInfos.back();
+		
+		cutterIsoms_model[k] = STOCK_MODEL_TRASLATION.inverse() * rototrasls[k];
+		modelIsoms_cutter[k] = cutterIsoms_model[k].inverse();
+		bboxIsoms_model[k] = cutterIsoms_model[k] * bboxInfo.rototraslation;
+		
+		ShiftedBox::calculateMinMax(cutterBboxMinMaxs[k], bboxIsoms_model[k], bboxInfo.extents);
+		
+		cutterInfos.push_back(new CutterInfos(cutters[k], &bboxInfo.extents,
+				&cutterIsoms_model[k], &modelIsoms_cutter[k], &bboxIsoms_model[k],
+				&cutterBboxMinMaxs[k]
+		));
+		intersectionTester.buildSeparatingRadii(cutterInfos.back(), k);
+		
+		if (k == 0) {
+			unionMinMax = cutterBboxMinMaxs[k];
+		} else {
+			unionMinMax.col(ShiftedBox::MIN_IDX) = unionMinMax.col(ShiftedBox::MIN_IDX).cwiseMin(
+					cutterBboxMinMaxs[k].col(ShiftedBox::MIN_IDX));
+			unionMinMax.col(ShiftedBox::MAX_IDX) = unionMinMax.col(ShiftedBox::MAX_IDX).cwiseMax(
+					cutterBboxMinMaxs[k].col(ShiftedBox::MAX_IDX));
+		}
+	}
 	
-	BranchNode::Ptr root = MODEL.getRoot();
+	ResultList results(nPoses);
+	PoseMask allPoses = (nPoses == MAX_POSES) ? ~PoseMask(0) : ((PoseMask(1) << nPoses) - 1);
 	
 	{
 		LockGuard l(mutex);
 		VersionInfo vinfo(lastRetrievedVersion, versioner.get() + 1);
-		RecursionInfo recInfo(cutterInfo, vinfo, results);
-		processTreeRecursive(root, recInfo);
+		
+		saveSnapshotSlices(unionMinMax);
+		
+		compactMin = compactMin.cwiseMin(unionMinMax.col(ShiftedBox::MIN_IDX));
+		compactMax = compactMax.cwiseMax(unionMinMax.col(ShiftedBox::MAX_IDX));
+		
+		// changes are logged only once the mesher has collected the model
+		RecursionInfo recInfo(cutterInfos, unionMinMax, vinfo, &results.front(),
+				lastRetrievedVersion ? &changedLeaves : NULL, SPLIT_DEPTH);
+		
+		boost::chrono::steady_clock::time_point descentStartTime = boost::chrono::steady_clock::now();
+		{
+			Trace::Scope descentScope("tree descent", "milling");
+			processModel(allPoses, recInfo);
+		}
+		boost::chrono::nanoseconds descentTime = boost::chrono::steady_clock::now() - descentStartTime;
+		
+		if (depthSwitchProfiler.isProfiling()) {
+			unsigned long analyzedLeaves = 0;
+			for (unsigned int k = 0; k < nPoses; ++k) {
+				analyzedLeaves += results[k].analyzed_leaves;
+			}
+			if (analyzedLeaves > 0 && depthSwitchProfiler.record(descentTime)) {
+				intersectionTester.setDepthSwitch(depthSwitchProfiler.getBest());
+			}
+		}
+		
 		/* we completed the production of the new version so now we can 
 		 * update versioner. It would have been wrong to update versioner
 		 * during VersionInfo creation because the new version wouldn't have
 		 * been completed yet (and theoretically should not be sent outside)
 		 */
 		versioner.incAndGet();
+		
+		/* the model is consistent only here, so if the mesher is waiting
+		 * for data it is handed the changes up to this version
+		 */
+		if (meshingHandoff.isRequested()) {
+			meshingHandoff.publish(collectChanges());
+		}
+	}
+	
+	/* thread time does not account for the work done by pool threads, so
+	 * when the pool is used the wall time is reported instead
+	 */
+	boost::chrono::microseconds elapsedTime;
+	if (POOL) {
+		elapsedTime = boost::chrono::duration_cast<boost::chrono::microseconds>(boost::chrono::steady_clock::now() - wallStartTime);
+	} else {
+		elapsedTime = boost::chrono::duration_cast<boost::chrono::microseconds>(boost::chrono::thread_clock::now() - startTime);
 	}
 	
-	results.elapsedTime = boost::chrono::duration_cast<boost::chrono::microseconds>(boost::chrono::thread_clock::now() - startTime);
+	for (unsigned int k = 0; k < nPoses; ++k) {
+		results[k].elapsedTime = elapsedTime / nPoses;
+	}
+	
+	Trace::sampleCounters();
 	
 	return results;
 }
 
-void Stock::processTreeRecursive(OctreeNode::Ptr branchNode, RecursionInfo &info) {
+void Stock::processModel(PoseMask poses, RecursionInfo &info) {
 	
-	BranchNode::Ptr branch = static_cast< BranchNode::Ptr >(branchNode);
+	std::vector< BranchNode::Ptr > path(1, MODEL->getRoot());
+	MortonCode::CodeType code = MortonCode::ROOT;
 	
-	for (int i = 0; i < BranchNode::N_CHILDREN; ++i) {
-		if (!branch->hasChild(i)) {
-			continue;
+	/* the cutter usually sticks out of the stock, but what lies outside
+	 * the root cannot intersect any node
+	 */
+	ShiftedBox box;
+	MODEL->getBox(path.back(), box);
+	ShiftedBox::MinMaxMatrix posesMinMax;
+	posesMinMax.col(ShiftedBox::MIN_IDX) = info.unionMinMax.col(ShiftedBox::MIN_IDX).cwiseMax(
+			box.getMatrix().col(ShiftedBox::MIN_IDX));
+	posesMinMax.col(ShiftedBox::MAX_IDX) = info.unionMinMax.col(ShiftedBox::MAX_IDX).cwiseMin(
+			box.getMatrix().col(ShiftedBox::MAX_IDX));
+	
+	/* when the poses are all out of the stock the clipped box is inverted:
+	 * any box would contain it, so the descent starts from the root
+	 */
+	const bool outside = (posesMinMax.col(ShiftedBox::MIN_IDX).array() >
+			posesMinMax.col(ShiftedBox::MAX_IDX).array()).any();
+	
+	// follow the cached branch as long as it still exists
+	const unsigned int cachedDepth = outside ? 0 : MortonCode::depth(descentStart);
+	for (unsigned int d = 1; d <= cachedDepth; ++d) {
+		unsigned char idx = MortonCode::childIdx(descentStart >> (3 * (cachedDepth - d)));
+		if (!path.back()->hasChild(idx)) {
+			break;
 		}
 		
-		OctreeNode::Ptr child = branch->getChild(i);
-		if (!intersectionTester.isIntersecting(child, info.cutterInfo)) {
-			continue;
+		OctreeNode::Ptr child = path.back()->getChild(idx);
+		if (child->getType() == OctreeNode::LEAF_NODE) {
+			break;
+		}
+		
+		path.push_back(static_cast< BranchNode::Ptr >(child));
+		code = MortonCode::child(code, idx);
+	}
+	
+	// go back up to a branch containing the poses, the root at worst
+	while (path.size() > 1) {
+		MODEL->getBox(path.back(), box);
+		if (box.isContaining(posesMinMax)) {
+			break;
 		}
 		
-		int procIdx = static_cast< int >(child->getType());
-		assert(procIdx >= 0 && procIdx < 2);
-		(this->*(PROCESSERS[procIdx]))(child, info);
+		path.pop_back();
+		code = MortonCode::father(code);
+	}
+	
+	if (code == descentStart && code != MortonCode::ROOT) {
+		info.results->descent_cache_hits++;
+	} else {
+		info.results->descent_cache_misses++;
+	}
+	
+	// then down to the deepest one
+	bool deeper = !outside;
+	while (deeper) {
+		deeper = false;
+		unsigned char children = path.back()->getChildrenMask();
+		for (int i = 0; i < BranchNode::N_CHILDREN && !deeper; ++i) {
+			if (!(children & (0x01 << i))) {
+				continue;
+			}
+			
+			OctreeNode::Ptr child = path.back()->getChild(i);
+			if (child->getType() == OctreeNode::LEAF_NODE) {
+				continue;
+			}
+			
+			MODEL->getBox(child, box);
+			if (box.isContaining(posesMinMax)) {
+				path.push_back(static_cast< BranchNode::Ptr >(child));
+				code = MortonCode::child(code, i);
+				deeper = true;
+			}
+		}
+	}
+	
+	// the next pass tries again from here, unless these poses missed the stock
+	if (!outside) {
+		descentStart = code;
 	}
 	
-	if (branch->isEmpty()) {
-		MODEL.deleteBranch(branch);
+	/* the skipped branches contain the poses bounding box, but the
+	 * intersection test could have discarded some poses anyway: they are
+	 * tested here as the descent from the root would have, so that the
+	 * start branch gets exactly the poses it would have got
+	 */
+	PoseMask startPoses = poses;
+	for (size_t i = 1; i < path.size() && startPoses; ++i) {
+		MODEL->getBox(path[i], box);
+		unsigned int depth = path[i]->getDepth();
+		for (unsigned int k = 0; k < info.getPosesNumber(); ++k) {
+			PoseMask pose = PoseMask(1) << k;
+			if ((startPoses & pose) && !intersectionTester.isIntersecting(box, depth, info.cutterInfos[k])) {
+				startPoses &= ~pose;
+			}
+		}
 	}
 	
+	if (!startPoses) {
+		return;
+	}
+	
+	info.splitDepth = path.back()->getDepth() + SPLIT_DEPTH;
+	processTreeRecursive(path.back(), startPoses, info);
+	
+	// the skipped ancestors may have been emptied as well
+	for (size_t i = path.size() - 1; i > 1; --i) {
+		if (!path[i - 1]->isEmpty()) {
+			break;
+		}
+		
+		MODEL->deleteBranch(path[i - 1], info.worker);
+	}
 }
 
-void Stock::analyzeLeaf(OctreeNode::Ptr leaf, RecursionInfo &info) {
+void Stock::processTreeRecursive(BranchNode::Ptr branch, PoseMask poses,
+		RecursionInfo &info, const unsigned char *childrenCorners) {
+	
+	/* processing a child can only remove the child itself from the branch,
+	 * so the mask read here stays valid for the following ones
+	 */
+	unsigned char children = branch->getChildrenMask();
+	
+	if (OctreeType::CONCURRENT_UPDATES && POOL && branch->getDepth() < info.splitDepth) {
+		processChildrenParallel(branch, children, poses, info);
+	} else {
+		for (int i = 0; i < BranchNode::N_CHILDREN; ++i) {
+			if (children & (0x01 << i)) {
+				processNode(branch->getChild(i), poses, info,
+						childrenCorners ? &childrenCorners[i] : NULL);
+			}
+		}
+	}
 	
-	LeafPtr currLeaf = static_cast< LeafPtr >(leaf);
+	if (branch->isEmpty() && !branch->isRoot()) {
+		MODEL->deleteBranch(branch, info.worker);
+	}
 	
-	assert(!currLeaf->getData()->isContained());
+}
+
+void Stock::processNode(OctreeNode::Ptr node, PoseMask poses,
+		RecursionInfo &info, const unsigned char *presetCorners) {
 	
-	info.results.analyzed_leaves++;
+	ShiftedBox box;
+	MODEL->getBox(node, box);
 	
-	/* by now we only know that cutter bounding box is intersecting
-	 * currLeaf (if the test has set to be faster but inaccurate it may
-	 * even not touching) but we have no clue about the fact that real
-	 * cutter is intersecting or not.
-	 * In order to do so we have to try to push model depth as deep as
-	 * allowed in order to check if some voxels are fully contained or, at
-	 * least, some of their corners are inside/outside cutter blade
-	 */
+	const unsigned int nPoses = info.getPosesNumber();
+	
+	// when there are more poses first discard nodes far from all of them
+	if (nPoses > 1 && !box.isIntersecting(info.unionMinMax)) {
+		return;
+	}
 	
-	WasteInfo waste;
-	cutVoxel(currLeaf, info.cutterInfo, waste);
+	unsigned int depth = node->getDepth();
+	PoseMask nodePoses = 0;
+	for (unsigned int k = 0; k < nPoses; ++k) {
+		PoseMask pose = PoseMask(1) << k;
+		if ((poses & pose) && intersectionTester.isIntersecting(box, depth, info.cutterInfos[k])) {
+			nodePoses |= pose;
+		}
+	}
 	
-	if (currLeaf->getData()->isContained()) {
+	if (!nodePoses) {
+		return;
+	}
+	
+	switch (node->getType()) {
+		case OctreeNode::LEAF_NODE: {
+			// preset corners refer to the first pose of the father
+			PoseMask firstPose = poses & (~poses + 1);
+			if (!(nodePoses & firstPose)) {
+				presetCorners = NULL;
+			}
+			
+			analyzeLeaf(static_cast< LeafNode::Ptr >(node), nodePoses, box, info, presetCorners);
+			break;
+		}
+		
+		case OctreeNode::BRANCH_NODE:
+			processTreeRecursive(static_cast< BranchNode::Ptr >(node), nodePoses, info);
+			break;
+			
+		default:
+			throw std::runtime_error("Unknown node type");
+	}
+}
+
+void Stock::processChildrenParallel(BranchNode::Ptr branch,
+		unsigned char children, PoseMask poses, RecursionInfo &info) {
+	
+	// branch links are read before any task may change them
+	boost::array< OctreeNode::Ptr, BranchNode::N_CHILDREN > childNodes;
+	for (int i = 0; i < BranchNode::N_CHILDREN; ++i) {
+		if (children & (0x01 << i)) {
+			childNodes[i] = branch->getChild(i);
+		}
+	}
+	
+	const unsigned int nPoses = info.getPosesNumber();
+	boost::array< ResultList, BranchNode::N_CHILDREN > partials;
+	boost::array< StoredData::VoxelData, BranchNode::N_CHILDREN > partialChanges;
+	WorkStealingPool::TaskGroup group;
+	
+	for (int i = 0; i < BranchNode::N_CHILDREN; ++i) {
+		if (!(children & (0x01 << i))) {
+			continue;
+		}
+		
+		partials[i].resize(nPoses);
+		POOL->submit(group, boost::bind(&Stock::processSubtree, this,
+				childNodes[i], poses,
+				boost::cref(info), &partials[i].front(),
+				info.changes ? &partialChanges[i] : NULL
+		));
+	}
+	
+	POOL->wait(group);
+	
+	for (int i = 0; i < BranchNode::N_CHILDREN; ++i) {
+		for (unsigned int k = 0; k < partials[i].size(); ++k) {
+			info.results[k] += partials[i][k];
+		}
+		
+		if (info.changes) {
+			info.changes->insert(info.changes->end(),
+					partialChanges[i].begin(), partialChanges[i].end());
+		}
+	}
+}
+
+void Stock::processSubtree(OctreeNode::Ptr node, PoseMask poses,
+		const RecursionInfo &parentInfo, IntersectionResult *results,
+		StoredData::VoxelData *changes) {
+	
+	Trace::Scope scope("subtree task", "milling");
+	
+	RecursionInfo info(parentInfo, results, changes, POOL->getThreadIdx());
+	processNode(node, poses, info);
+}
+
+void Stock::analyzeLeaf(LeafNode::Ptr currLeaf, PoseMask poses,
+		const ShiftedBox &box, RecursionInfo &info, const unsigned char *presetCorners) {
+	
+	VoxelInfo::Ptr data = currLeaf->getData();
+	
+	const unsigned int nPoses = info.getPosesNumber();
+	for (unsigned int k = 0; k < nPoses; ++k) {
+		if (!(poses & (PoseMask(1) << k))) {
+			continue;
+		}
 		
-		info.results.purged_leaves++;
-		info.results.waste += calculateNewWaste(currLeaf, waste);
+		assert(!data->isContained());
 		
-		// add stored info to the deleted data deque
-		deletedQueuer.enqueue(currLeaf->getData());
+		IntersectionResult &results = info.results[k];
+		results.analyzed_leaves++;
 		
-		// then delete currLeaf from the model
-		MODEL.deleteLeaf(currLeaf);
+		/* by now we only know that cutter bounding box is intersecting
+		 * currLeaf (if the test has set to be faster but inaccurate it may
+		 * even not touching) but we have no clue about the fact that real
+		 * cutter is intersecting or not.
+		 * In order to do so we have to try to push model depth as deep as
+		 * allowed in order to check if some voxels are fully contained or, at
+		 * least, some of their corners are inside/outside cutter blade
+		 */
 		
-	} else {
+		unsigned char insideCorners;
+		if (presetCorners) {
+			insideCorners = *presetCorners;
+			presetCorners = NULL;
+		} else {
+			insideCorners = getInsideCorners(box, info.cutterInfos[k]);
+		}
+		
+		WasteInfo waste;
+		cutVoxel(data, insideCorners, waste);
+		
+		if (data->isContained()) {
+			
+			results.purged_leaves++;
+			results.waste += calculateNewWaste(box, waste);
+			
+			// add stored info to the deleted data deque
+			deletedQueuer.enqueue(data);
+			
+			// then delete currLeaf from the model: next poses cannot cut it
+			MODEL->deleteLeaf(currLeaf, info.worker);
+			return;
+			
+		}
 		
 		// currLeaf is probably half inside and half outside
 		
-		if (canPushLevel(currLeaf)) {
+		if (canPushLevel(currLeaf->getDepth())) {
 			
-			info.results.pushed_leaves++;
+			results.pushed_leaves++;
 			
 			// pushing cause current leaf to be deleted
-			deletedQueuer.enqueue(currLeaf->getData());
+			deletedQueuer.enqueue(data);
 			
 			// we can push another level so let's do it...
-			BranchNode::Ptr newBranch = MODEL.pushLeaf(currLeaf, info.vinfo);
-			
-			// ... and recursively process it
-			processTreeRecursive(newBranch, info);
-			
-		} else {
+			BranchNode::Ptr newBranch;
+			{
+				Trace::Scope pushScope("pushLeaf", "milling");
+				newBranch = MODEL->pushLeaf(currLeaf, info.vinfo, info.worker);
+			}
 			
-			/* leaf is intersecting but i cannot push more levels
-			 * so let's update saved data incrementing waste count!
-			 * 
-			 * we reach this point even in the following conditions:
-			 * cutter is really intersecting but we don't have enough voxel
-			 * resolution or we stuck upon a bounding-box approximation error;
-			 */
+			// all the children are new leaves
+			for (int i = 0; i < BranchNode::N_CHILDREN; ++i) {
+				logChange(static_cast< LeafNode::Ptr >(newBranch->getChild(i)), info);
+			}
 			
-			info.results.updated_data_leaves++;
+			// corners shared among the children are tested only once...
+			ShiftedBox firstChildBox;
+			MODEL->getBox(newBranch->getChild(0), firstChildBox);
 			
-			info.results.waste += calculateNewWaste(currLeaf, waste);
+			unsigned char childrenCorners[BranchNode::N_CHILDREN];
+			getChildrenCorners(box, firstChildBox, info.cutterInfos[k], childrenCorners);
 			
-			MODEL.updateData(currLeaf, info.vinfo);
+			/* ... and the new branch is recursively processed with this pose
+			 * and the following ones, exactly as they would have found it
+			 */
+			PoseMask nextPoses = poses & ~((PoseMask(1) << k) - 1);
+			processTreeRecursive(newBranch, nextPoses, info, childrenCorners);
+			return;
 			
-		} // if (canPushLevel)
-	} // if (isContained)	
+		}
+		
+		/* leaf is intersecting but i cannot push more levels
+		 * so let's update saved data incrementing waste count!
+		 * 
+		 * we reach this point even in the following conditions:
+		 * cutter is really intersecting but we don't have enough voxel
+		 * resolution or we stuck upon a bounding-box approximation error;
+		 */
+		
+		results.updated_data_leaves++;
+		
+		results.waste += calculateNewWaste(box, waste);
+		
+		if (MODEL->updateData(currLeaf, info.vinfo)) {
+			logChange(currLeaf, info);
+		}
+	}
 }
 
-void Stock::cutVoxel(const LeafPtr &leaf,
-		const CutterInfos &cutterInfo, WasteInfo &waste) const {
+void Stock::logChange(LeafNode::ConstPtr leaf, const RecursionInfo &info) const {
 	
-	/* we have to convert stockPoint in cutter basis: given isometry
-	 * is for the cutter in respect of model basis, so we
-	 * have to invert it to get model's roto-traslation in respect of
-	 * cutter basis, that is, the isometry that converts model points in
-	 * cutter points.
+	if (info.changes) {
+		// corners are copied when the log is collected
+		info.changes->push_back(StoredData::VoxelPair(
+				MODEL->buildBox(leaf),
+				leaf->getData(),
+				0
+		));
+	}
+}
+
+void Stock::cutVoxel(const VoxelInfo::Ptr &info, unsigned char insideCorners,
+		WasteInfo &waste) const {
+	
+	Trace::Scope scope("cutVoxel", "milling");
+	
+	/* corners already cut are simply ignored by the update: testing them
+	 * again is cheaper than skipping them one by one
 	 */
-	const ShiftedBox::ConstPtr &box = leaf->getBox();
-	Eigen::Isometry3d modelIsom_cutter = cutterInfo.cutterIsom_model->inverse();
+	unsigned char newInside = info->updateInsideCorners(insideCorners);
 	
-	VoxelInfo::Ptr info = leaf->getData();
 	waste.reset();
-	for (CornerIterator cit = CornerIterator::begin(); cit != CornerIterator::end(); ++cit) {
-		if(info->isCornerCut(*cit)) {
-			continue;
-		}
+	waste.newInsideCorners = BitUtils::popCount(newInside);
+}
+
+unsigned char Stock::getInsideCorners(const ShiftedBox &box, const CutterInfos &cutterInfo) const {
+	
+	/* we have to convert stockPoint in cutter basis: given isometry
+	 * is for the cutter in respect of model basis, so we use its inverse,
+	 * that is, the isometry that converts model points in cutter points.
+	 */
+	CornerCoords corners;
+	box.getCorners(*cutterInfo.modelIsom_cutter, corners);
+	
+	return cutterInfo.cutter->getInsideCorners(corners);
+}
+
+namespace {
+
+/**
+ * @class ChildrenLattice
+ *
+ * The corners of the children of a box lie on a 3x3x3 lattice, whose
+ * points are indexed as x * 9 + y * 3 + z, each coordinate being 0 (min of
+ * the father), 1 (middle) or 2 (max of the father).
+ */
+struct ChildrenLattice {
+	
+	static const int N_POINTS = 27;
+	
+	/** number of lattice points that are not corners of the father */
+	static const int N_NEW_POINTS = 19;
+	
+	int newPoints[N_NEW_POINTS];
+	
+	/** lattice point of each corner of each child */
+	int childCorners[BranchNode::N_CHILDREN][Corner::N_CORNERS];
+	
+	ChildrenLattice() {
+		// see Corner::CornerType
+		static const int CORNER_OFFSETS[][3] = {
+			{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0},
+			{0, 0, 1}, {1, 0, 1}, {1, 1, 1}, {0, 1, 1}
+		};
 		
-		Eigen::Vector3d point = box->getCorner(*cit, modelIsom_cutter);
+		int n = 0;
+		for (int p = 0; p < N_POINTS; ++p) {
+			if ((p / 9) % 2 || (p / 3) % 3 % 2 || p % 3 % 2) {
+				newPoints[n++] = p;
+			}
+		}
+		assert(n == N_NEW_POINTS);
 		
-		double distance = cutterInfo.cutter->getDistance(point);
+		// child index bits: X (bit 2), Y (bit 1), Z (bit 0)
+		for (int child = 0; child < BranchNode::N_CHILDREN; ++child) {
+			for (int c = 0; c < Corner::N_CORNERS; ++c) {
+				int x = ((child >> 2) & 0x01) + CORNER_OFFSETS[c][0];
+				int y = ((child >> 1) & 0x01) + CORNER_OFFSETS[c][1];
+				int z = (child & 0x01) + CORNER_OFFSETS[c][2];
+				
+				childCorners[child][c] = x * 9 + y * 3 + z;
+			}
+		}
+	}
+	
+	static const ChildrenLattice &get() {
+		static const ChildrenLattice lattice;
+		return lattice;
+	}
+};
+
+}
+
+void Stock::getChildrenCorners(const ShiftedBox &fatherBox, const ShiftedBox &firstChildBox,
+		const CutterInfos &cutterInfo, unsigned char childrenCorners[]) const {
+	
+	const ChildrenLattice &lattice = ChildrenLattice::get();
+	
+	/* middle coordinates are taken from a child box so that points are
+	 * exactly the corners the children would compute
+	 */
+	const ShiftedBox::MinMaxMatrix &father = fatherBox.getMatrix();
+	const double coords[3][3] = {
+		{ father(0, ShiftedBox::MIN_IDX), firstChildBox.getMatrix()(0, ShiftedBox::MAX_IDX), father(0, ShiftedBox::MAX_IDX) },
+		{ father(1, ShiftedBox::MIN_IDX), firstChildBox.getMatrix()(1, ShiftedBox::MAX_IDX), father(1, ShiftedBox::MAX_IDX) },
+		{ father(2, ShiftedBox::MIN_IDX), firstChildBox.getMatrix()(2, ShiftedBox::MAX_IDX), father(2, ShiftedBox::MAX_IDX) }
+	};
+	
+	// new points are tested in groups of Corner::N_CORNERS
+	boost::uint32_t insidePoints = 0;
+	for (int first = 0; first < ChildrenLattice::N_NEW_POINTS; first += Corner::N_CORNERS) {
+		CornerCoords points, cutterPoints;
+		for (int i = 0; i < Corner::N_CORNERS; ++i) {
+			// last group is filled repeating its first point
+			int p = lattice.newPoints[(first + i < ChildrenLattice::N_NEW_POINTS) ? first + i : first];
+			points.x[i] = coords[0][p / 9];
+			points.y[i] = coords[1][(p / 3) % 3];
+			points.z[i] = coords[2][p % 3];
+		}
 		
-		bool newInside = info->updateInsideness(*cit, distance);
+		ShiftedBox::transformCorners(points, *cutterInfo.modelIsom_cutter, cutterPoints);
+		unsigned char inside = cutterInfo.cutter->getInsideCorners(cutterPoints);
 		
-		// note that a true bool casted to int is always converted to 1, 0 otherwise
-		waste.newInsideCorners += (int)newInside;
+		for (int i = 0; i < Corner::N_CORNERS && first + i < ChildrenLattice::N_NEW_POINTS; ++i) {
+			if (inside & (0x01 << i)) {
+				insidePoints |= boost::uint32_t(1) << lattice.newPoints[first + i];
+			}
+		}
+	}
+	
+	for (int child = 0; child < BranchNode::N_CHILDREN; ++child) {
+		childrenCorners[child] = 0;
+		for (int c = 0; c < Corner::N_CORNERS; ++c) {
+			childrenCorners[child] |= ((insidePoints >> lattice.childCorners[child][c]) & 0x01) << c;
+		}
 	}
 }
 
-double Stock::calculateNewWaste(const LeafPtr &currLeaf, const WasteInfo &info) {
-	return currLeaf->getBox()->getVolume() * 
+double Stock::calculateNewWaste(const ShiftedBox &box, const WasteInfo &info) {
+	return box.getVolume() * 
 			info.newInsideCorners / (double) Corner::N_CORNERS;
 }
 
 
-bool Stock::canPushLevel(const LeafPtr &leaf) const {
-	return leaf->getDepth() < this->MAX_DEPTH;
+bool Stock::canPushLevel(unsigned int depth) const {
+	return depth < this->MAX_DEPTH;
 }
 
 
@@ -258,8 +767,8 @@ std::ostream & operator<<(std::ostream &os, const Stock &stock) {
 	return os;
 }
 
-void Stock::buildChangedNodesQueue(BranchNode::ConstPtr node,
-			const VersionInfo &vinfo, StoredData::VoxelData &queue) const {
+void Stock::buildLeavesQueue(BranchNode::ConstPtr node,
+			StoredData::VoxelData &queue) const {
 
 	for(int i = 0; i < BranchNode::N_CHILDREN; ++i) {
 		if (!node->hasChild(i)) {
@@ -267,23 +776,16 @@ void Stock::buildChangedNodesQueue(BranchNode::ConstPtr node,
 		}
 		
 		OctreeNode::Ptr child = node->getChild(i);
-		if(!child->isChanged(vinfo)) {
-			continue;
-		}
-		
 		switch (child->getType()) {
 			case OctreeNode::BRANCH_NODE:
-				buildChangedNodesQueue(
-						static_cast< BranchNode::ConstPtr >(child),
-						vinfo,
-						queue
-				);
+				buildLeavesQueue(static_cast< BranchNode::ConstPtr >(child), queue);
 				break;
 			case OctreeNode::LEAF_NODE: {
-				LeafNode::Ptr leaf = static_cast< LeafNode::Ptr >(child);
+				VoxelInfo::Ptr data = static_cast< LeafNode::ConstPtr >(child)->getData();
 				StoredData::VoxelPair vpair(
-						leaf->getBox(),
-						leaf->getData()
+						MODEL->buildBox(child),
+						data,
+						data->getInsideCorners()
 				);
 				queue.push_back(vpair);
 				break;
@@ -295,50 +797,466 @@ void Stock::buildChangedNodesQueue(BranchNode::ConstPtr node,
 	}
 }
 
-Mesh::Ptr Stock::getMeshing() {
-	const static osg::Vec3d TRANSLATION(
-			STOCK_MODEL_TRASLATION.translation()[0],
-			STOCK_MODEL_TRASLATION.translation()[1],
-			STOCK_MODEL_TRASLATION.translation()[2]
-	);
+void Stock::countNodes(BranchNode::ConstPtr node, NodesCount &count) const {
+
+	for(int i = 0; i < BranchNode::N_CHILDREN; ++i) {
+		if (!node->hasChild(i)) {
+			continue;
+		}
+		
+		OctreeNode::Ptr child = node->getChild(i);
+		if (child->getType() == OctreeNode::LEAF_NODE) {
+			count.leaves++;
+		} else {
+			count.branches++;
+			countNodes(static_cast< BranchNode::ConstPtr >(child), count);
+		}
+	}
+}
+
+unsigned int Stock::getDepthSwitch() const {
+	return intersectionTester.getDepthSwitch();
+}
+
+Stock::NodesCount Stock::countNodes() const {
+	LockGuard l(mutex);
 	
-	deletedQueuer.activate();
-	StoredData::VoxelDataPtr data = boost::make_shared< StoredData::VoxelData >();
-	StoredData::DeletedDataPtr newDeleted;
-	BranchNode::ConstPtr root = MODEL.getRoot();
+	NodesCount count;
+	count.branches = 1; // the root
+	countNodes(MODEL->getRoot(), count);
+	
+	return count;
+}
+
+bool Stock::compactSubtree(BranchNode::Ptr branch,
+		const ShiftedBox::MinMaxMatrix &region, const VersionInfo &vinfo,
+		unsigned long &merged) {
+	
+	// a branch missing some children cannot be represented by a leaf
+	bool uniform = (branch->getChildrenMask() == 0xff);
+	
+	for(int i = 0; i < BranchNode::N_CHILDREN; ++i) {
+		if (!branch->hasChild(i)) {
+			continue;
+		}
+		
+		OctreeNode::Ptr child = branch->getChild(i);
+		if (child->getType() == OctreeNode::LEAF_NODE) {
+			uniform = uniform && !static_cast< LeafNode::Ptr >(child)->getData()->isIntersecting();
+			continue;
+		}
+		
+		// branches out of the region were not mergeable at last compaction
+		BranchNode::Ptr childBranch = static_cast< BranchNode::Ptr >(child);
+		ShiftedBox box;
+		MODEL->getBox(childBranch, box);
+		if (!box.isIntersecting(region) || !compactSubtree(childBranch, region, vinfo, merged)) {
+			uniform = false;
+			continue;
+		}
+		
+		// the mesher has to forget the merged leaves...
+		for (int j = 0; j < BranchNode::N_CHILDREN; ++j) {
+			deletedQueuer.enqueue(static_cast< LeafNode::Ptr >(childBranch->getChild(j))->getData());
+		}
+		
+		LeafNode::Ptr leaf = MODEL->mergeBranch(childBranch, vinfo);
+		merged++;
+		
+		// ...and to learn the new one
+		if (lastRetrievedVersion) {
+			changedLeaves.push_back(StoredData::VoxelPair(
+					MODEL->buildBox(leaf), leaf->getData(), 0));
+		}
+	}
+	
+	return uniform;
+}
+
+unsigned long Stock::compact() {
+	Trace::Scope scope("compact", "milling");
+	
+	LockGuard l(mutex);
+	
+	ShiftedBox::MinMaxMatrix region;
+	region.col(ShiftedBox::MIN_IDX) = compactMin;
+	region.col(ShiftedBox::MAX_IDX) = compactMax;
+	
+	VersionInfo vinfo(lastRetrievedVersion, versioner.get() + 1);
+	unsigned long merged = 0;
+	
+	saveSnapshotSlices(region);
+	compactSubtree(MODEL->getRoot(), region, vinfo, merged);
+	
+	compactMin.setConstant(std::numeric_limits< double >::infinity());
+	compactMax.setConstant(-std::numeric_limits< double >::infinity());
+	
+	// as after an intersection (see #intersect)
+	versioner.incAndGet();
+	if (meshingHandoff.isRequested()) {
+		meshingHandoff.publish(collectChanges());
+	}
+	
+	return merged;
+}
+
+void Stock::saveSubtree(BranchNode::ConstPtr branch, SnapshotStreams &streams) {
+	
+	// the branches mask is known only once the children are visited
+	const std::size_t record = streams.branches.size();
+	streams.branches.push_back(branch->getChildrenMask());
+	streams.branches.push_back(0);
+	
+	for(int i = 0; i < BranchNode::N_CHILDREN; ++i) {
+		if (!branch->hasChild(i)) {
+			continue;
+		}
+		
+		OctreeNode::Ptr child = branch->getChild(i);
+		if (child->getType() == OctreeNode::LEAF_NODE) {
+			streams.leaves.push_back(static_cast< LeafNode::ConstPtr >(child)->getData()->getInsideCorners());
+		} else {
+			streams.branches[record + 1] |= 0x01 << i;
+			saveSubtree(static_cast< BranchNode::ConstPtr >(child), streams);
+		}
+	}
+}
+
+void Stock::loadSubtree(BranchNode::Ptr branch, SnapshotStreams &streams) {
+	
+	if (streams.nextBranch + 2 > streams.branches.size()) {
+		throw std::runtime_error("truncated model snapshot");
+	}
+	const unsigned char childrenMask = streams.branches[streams.nextBranch++];
+	const unsigned char branchesMask = streams.branches[streams.nextBranch++];
+	if (branchesMask & ~childrenMask) {
+		throw std::runtime_error("corrupted model snapshot");
+	}
+	
+	// the model is rebuilt as it was before the first version
+	const VersionInfo vinfo(1, 1);
+	
+	for(int i = 0; i < BranchNode::N_CHILDREN; ++i) {
+		LeafNode::Ptr child = static_cast< LeafNode::Ptr >(branch->getChild(i));
+		
+		if (!(childrenMask & (0x01 << i))) {
+			MODEL->deleteLeaf(child);
+			
+		} else if (branchesMask & (0x01 << i)) {
+			if (!canPushLevel(child->getDepth())) {
+				throw std::runtime_error("model snapshot is deeper than the model");
+			}
+			loadSubtree(MODEL->pushLeaf(child, vinfo), streams);
+			
+		} else {
+			if (streams.nextLeaf >= streams.leaves.size()) {
+				throw std::runtime_error("truncated model snapshot");
+			}
+			// children are new leaves, with no inside corner
+			child->getData()->updateInsideCorners(streams.leaves[streams.nextLeaf++]);
+		}
+	}
+}
+
+void Stock::sliceSubtree(BranchNode::ConstPtr branch, Snapshot &snapshot) const {
+	
+	if (branch->getDepth() >= SNAPSHOT_SLICES_DEPTH) {
+		Snapshot::Slice *slice = new Snapshot::Slice();
+		slice->branch = branch;
+		ShiftedBox box;
+		MODEL->getBox(branch, box);
+		slice->box = box.getMatrix();
+		slice->state = Snapshot::Slice::PENDING;
+		
+		snapshot.slices.push_back(slice);
+		snapshot.pendingSlices.incAndGet();
+		
+		// the nodes following the subtree go in a new slice
+		snapshot.slices.push_back(new Snapshot::Slice());
+		return;
+	}
+	
+	// the branches mask is known only once the children are visited
+	SnapshotStreams &streams = snapshot.slices.back().streams;
+	const std::size_t record = streams.branches.size();
+	streams.branches.push_back(branch->getChildrenMask());
+	streams.branches.push_back(0);
+	
+	for(int i = 0; i < BranchNode::N_CHILDREN; ++i) {
+		if (!branch->hasChild(i)) {
+			continue;
+		}
+		
+		OctreeNode::Ptr child = branch->getChild(i);
+		if (child->getType() == OctreeNode::LEAF_NODE) {
+			// previous children may have started a new slice
+			snapshot.slices.back().streams.leaves.push_back(
+					static_cast< LeafNode::ConstPtr >(child)->getData()->getInsideCorners());
+		} else {
+			streams.branches[record + 1] |= 0x01 << i;
+			sliceSubtree(static_cast< BranchNode::ConstPtr >(child), snapshot);
+		}
+	}
+}
+
+void Stock::saveSnapshotSlices(const ShiftedBox::MinMaxMatrix &region) {
+	Snapshot::ConstPtr snapshot = pendingSnapshot.lock();
+	if (snapshot) {
+		snapshot->saveSlices(region);
+	}
+	
+	if (!snapshot || snapshot->isSaved()) {
+		pendingSnapshot.reset();
+	}
+}
+
+void Stock::completeSnapshot() const {
+	Snapshot::ConstPtr snapshot = pendingSnapshot.lock();
+	if (snapshot) {
+		snapshot->saveSlices();
+	}
+	
+	pendingSnapshot.reset();
+}
+
+Stock::Snapshot::ConstPtr Stock::takeSnapshot() const {
+	Trace::Scope scope("takeSnapshot", "milling");
+	
+	boost::shared_ptr< Snapshot > snapshot = boost::make_shared< Snapshot >();
+	snapshot->slices.push_back(new Snapshot::Slice());
 	{
-		// acquire lock
 		LockGuard l(mutex);
 		
-		// build & update version informations
-		VersionInfo currVinfo(lastRetrievedVersion, versioner.get());
-		lastRetrievedVersion = versioner.get();
-		
-		// build new & updated data queue
-		if (root->isChanged(currVinfo)) {
-			buildChangedNodesQueue(root, currVinfo, *data);
+		completeSnapshot();
+		sliceSubtree(MODEL->getRoot(), *snapshot);
+		pendingSnapshot = snapshot;
+	}
+	
+	// node counts are known only once all the slices are saved
+	SnapshotHeader &header = snapshot->header;
+	header.magic = SNAPSHOT_MAGIC;
+	header.version = SNAPSHOT_VERSION;
+	header.maxDepth = MAX_DEPTH;
+	header.reserved = 0;
+	for (int i = 0; i < 3; ++i) {
+		header.extent[i] = EXTENT[i];
+	}
+	header.nBranches = 0;
+	header.nLeaves = 0;
+	
+	return snapshot;
+}
+
+void Stock::Snapshot::saveSlice(Slice &slice) const {
+	{
+		boost::unique_lock< boost::mutex > l(mutex);
+		while (slice.state == Slice::SAVING) {
+			sliceSaved.wait(l);
+		}
+		if (slice.state == Slice::SAVED) {
+			return;
+		}
+		slice.state = Slice::SAVING;
+	}
+	
+	saveSubtree(slice.branch, slice.streams);
+	slice.branch = NULL;
+	
+	{
+		boost::lock_guard< boost::mutex > l(mutex);
+		slice.state = Slice::SAVED;
+		pendingSlices.decAndGet();
+	}
+	sliceSaved.notify_all();
+}
+
+void Stock::Snapshot::saveSlices() const {
+	boost::ptr_vector< Slice >::iterator it = slices.begin();
+	for (; it != slices.end() && !isSaved(); ++it) {
+		saveSlice(*it);
+	}
+}
+
+void Stock::Snapshot::saveSlices(const ShiftedBox::MinMaxMatrix &region) const {
+	boost::ptr_vector< Slice >::iterator it = slices.begin();
+	for (; it != slices.end() && !isSaved(); ++it) {
+		// as ShiftedBox::isIntersecting, boxes are closed
+		if ((it->box.col(ShiftedBox::MAX_IDX).array() < region.col(ShiftedBox::MIN_IDX).array()).any() ||
+				(it->box.col(ShiftedBox::MIN_IDX).array() > region.col(ShiftedBox::MAX_IDX).array()).any()) {
+			continue;
 		}
 		
-		/* TODO nella gestione della concorrenza rimane un problema: i
-		 * VoxelInfo mandati al mesher sono comunque condivisi con il miller
-		 * quindi potrebbe accadere che per due voxel adiacenti il mesher ne
-		 * calcoli uno con un vertice eroso e un'altro con il vertice ancora
-		 * posizionato. In caso di stepping mode (o comunque nell'ultima
-		 * visualizzazione) tutti questi artifatti spariscono in quanto
-		 * milling e meshing hanno una relazione happens-before
-		 */
+		saveSlice(*it);
+	}
+}
+
+void Stock::Snapshot::write(std::ostream &os) const {
+	Trace::Scope scope("writeSnapshot", "milling");
+	
+	saveSlices();
+	
+	SnapshotHeader fullHeader = header;
+	boost::ptr_vector< Slice >::const_iterator it = slices.begin();
+	for (; it != slices.end(); ++it) {
+		fullHeader.nBranches += it->streams.branches.size() / 2;
+		fullHeader.nLeaves += it->streams.leaves.size();
+	}
+	os.write(reinterpret_cast< const char * >(&fullHeader), sizeof(fullHeader));
+	
+	// all the branches, then all the leaves, slice by slice
+	for (it = slices.begin(); it != slices.end(); ++it) {
+		if (!it->streams.branches.empty()) {
+			os.write(reinterpret_cast< const char * >(&it->streams.branches.front()), it->streams.branches.size());
+		}
+	}
+	for (it = slices.begin(); it != slices.end(); ++it) {
+		if (!it->streams.leaves.empty()) {
+			os.write(reinterpret_cast< const char * >(&it->streams.leaves.front()), it->streams.leaves.size());
+		}
+	}
+	
+	if (os.fail()) {
+		throw std::runtime_error("error writing model snapshot");
+	}
+}
+
+std::size_t Stock::Snapshot::getSize() const {
+	saveSlices();
+	
+	std::size_t size = sizeof(header);
+	boost::ptr_vector< Slice >::const_iterator it = slices.begin();
+	for (; it != slices.end(); ++it) {
+		size += it->streams.branches.size() + it->streams.leaves.size();
+	}
+	
+	return size;
+}
+
+void Stock::loadModel(std::istream &is) {
+	Trace::Scope scope("loadModel", "milling");
+	
+	SnapshotHeader header;
+	if (!is.read(reinterpret_cast< char * >(&header), sizeof(header))) {
+		throw std::runtime_error("truncated model snapshot");
+	}
+	if (header.magic != SNAPSHOT_MAGIC || header.version != SNAPSHOT_VERSION) {
+		throw std::runtime_error("not a model snapshot, or unsupported version");
+	}
+	if (header.maxDepth != MAX_DEPTH ||
+			header.extent[0] != EXTENT[0] || header.extent[1] != EXTENT[1] || header.extent[2] != EXTENT[2]) {
+		throw std::runtime_error("model snapshot does not match stock extent and max depth");
+	}
+	if (header.nBranches == 0) {
+		throw std::runtime_error("corrupted model snapshot");
+	}
+	
+	// streams are read in one go...
+	SnapshotStreams streams;
+	streams.branches.resize(2 * header.nBranches);
+	streams.leaves.resize(header.nLeaves);
+	is.read(reinterpret_cast< char * >(&streams.branches.front()), streams.branches.size());
+	if (!streams.leaves.empty()) {
+		is.read(reinterpret_cast< char * >(&streams.leaves.front()), streams.leaves.size());
+	}
+	if (!is) {
+		throw std::runtime_error("truncated model snapshot");
+	}
+	
+	// ...then the tree is rebuilt in memory
+	LockGuard l(mutex);
+	
+	if (lastRetrievedVersion != 0 || versioner.get() != 2) {
+		throw std::runtime_error("model can be loaded only before milling and meshing");
+	}
+	
+	completeSnapshot();
+	loadSubtree(MODEL->getRoot(), streams);
+	
+	if (streams.nextBranch != streams.branches.size() || streams.nextLeaf != streams.leaves.size()) {
+		throw std::runtime_error("corrupted model snapshot");
+	}
+}
+
+StoredData *Stock::collectChanges() {
+	Trace::Scope scope("collectChanges", "meshing");
+	
+	StoredData::VoxelDataPtr data = boost::make_shared< StoredData::VoxelData >();
+	StoredData::DeletedDataPtr deleted = deletedQueuer.renewQueue();
+	
+	if (lastRetrievedVersion == 0) {
+		// first collection: nothing has been logged yet
+		buildLeavesQueue(MODEL->getRoot(), *data);
 		
-		// renew deletedDataPtr
-		newDeleted = deletedQueuer.renewQueue();
+	} else {
+		// logged leaves may have been deleted (or pushed) afterwards
+		std::vector< const VoxelInfo * > deletedInfos;
+		deletedInfos.reserve(deleted->size());
+		StoredData::DeletedData::const_iterator delIt = deleted->begin();
+		for (; delIt != deleted->end(); ++delIt) {
+			deletedInfos.push_back(delIt->get());
+		}
+		std::sort(deletedInfos.begin(), deletedInfos.end());
 		
-		// release lock
+		StoredData::VoxelData::iterator it = changedLeaves.begin();
+		for (; it != changedLeaves.end(); ++it) {
+			if (std::binary_search(deletedInfos.begin(), deletedInfos.end(), it->vinfo.get())) {
+				continue;
+			}
+			
+			it->insideCorners = it->vinfo->getInsideCorners();
+			data->push_back(*it);
+		}
+	}
+	
+	changedLeaves.clear();
+	lastRetrievedVersion = versioner.get();
+	
+	return new StoredData(data, deleted);
+}
+
+Mesh::Ptr Stock::getMeshing() {
+	const static osg::Vec3d TRANSLATION(
+			STOCK_MODEL_TRASLATION.translation()[0],
+			STOCK_MODEL_TRASLATION.translation()[1],
+			STOCK_MODEL_TRASLATION.translation()[2]
+	);
+	
+	deletedQueuer.activate();
+	
+	/* if the miller is idle (paused, stepping or finished) nobody would
+	 * publish its last changes, so they are collected here. While the
+	 * miller is cutting the lock is busy and the mesher simply goes on with
+	 * the data it published
+	 */
+	boost::unique_lock< boost::mutex > lock(mutex, boost::try_to_lock);
+	
+	/* data is published under the lock, so if it is owned nothing can be
+	 * published until the changes below are collected
+	 */
+	PtrHandoff< StoredData >::Ptr published = meshingHandoff.take();
+	boost::scoped_ptr< StoredData > changes;
+	if (lock.owns_lock()) {
+		changes.reset(collectChanges());
+		lock.unlock();
+	}
+	
+	// changes are applied in the order they were collected
+	Mesh::Ptr mesh;
+	if (published) {
+		mesh = MESHER->buildMesh(*published);
+	}
+	if (changes) {
+		mesh = MESHER->buildMesh(*changes);
 	}
 	
-	// build StoredData based on updatedData & deletedData
-	StoredData storedData(data, newDeleted);
+	meshingHandoff.request();
 	
-	// invoke mesher
-	Mesh::Ptr mesh = MESHER->buildMesh(storedData);
+	if (!mesh) {
+		// nothing new: ask the mesher for the current mesh
+		StoredData noChanges(boost::make_shared< StoredData::VoxelData >(),
+				boost::make_shared< StoredData::DeletedData >());
+		mesh = MESHER->buildMesh(noChanges);
+	}
 	
 	// apply translation to given mesh
 	osg::PositionAttitudeTransform *PAT = new osg::PositionAttitudeTransform;
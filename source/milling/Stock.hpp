@@ -12,21 +12,34 @@
 
 #include <cassert>
 #include <algorithm>
+#include <istream>
 #include <ostream>
+#include <vector>
 
 #include <boost/chrono.hpp>
+#include <boost/noncopyable.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
 
 #include <Eigen/Geometry>
+#include <Eigen/StdVector>
 
 #include "common/Model3D.hpp"
 #include "common/AtomicNumber.hpp"
+#include "common/Trace.hpp"
 #include "configuration/StockDescription.hpp"
+#include "threading/WorkStealingPool.hpp"
 #include "meshing/Mesher.hpp"
 #include "Cutter.hpp"
 #include "VoxelInfo.hpp"
 #include "Octree.hpp"
 #include "IntersectionResult.hpp"
+#include "PtrHandoff.hpp"
 #include "StoredData.hpp"
 
 /**
@@ -43,7 +56,73 @@ public:
 	typedef Octree OctreeType;
 	typedef Mesher< StoredData > MesherType;
 	
+	typedef std::vector< Eigen::Isometry3d,
+			Eigen::aligned_allocator< Eigen::Isometry3d > > PoseList;
+	typedef std::vector< IntersectionResult > ResultList;
+	typedef std::vector< Cutter::ConstPtr > CutterList;
+	
+	class Snapshot;
+	
+	/** maximum number of poses #intersect can process in a single pass */
+	static const unsigned int MAX_POSES = 64;
+	
+	/**
+	 * the depth switch is chosen profiling the first passes of #intersect
+	 * that analyze some leaves (see DepthSwitchProfiler). Different depths
+	 * discard different nodes, so the analyzed leaves, and possibly the
+	 * milled voxels, depend on the chosen depth: results may differ from a
+	 * run to another
+	 */
+	static const int AUTO_DEPTH_SWITCH = -1;
+	
+	/**
+	 * number of nodes of the model
+	 */
+	struct NodesCount {
+		unsigned long branches;
+		unsigned long leaves;
+		
+		NodesCount() : branches(0), leaves(0) { }
+	};
+	
 private:
+	
+	static const boost::uint32_t SNAPSHOT_MAGIC = 0x534e4e43; // "CNNS"
+	static const boost::uint32_t SNAPSHOT_VERSION = 1;
+	
+	/**
+	 * depth of the branches whose subtrees are copied after the snapshot is
+	 * taken (see Snapshot)
+	 */
+	static const unsigned int SNAPSHOT_SLICES_DEPTH = 3;
+	
+	/**
+	 * header of the model snapshots (see Snapshot::write)
+	 */
+	struct SnapshotHeader {
+		boost::uint32_t magic;
+		boost::uint32_t version;
+		boost::uint32_t maxDepth;
+		boost::uint32_t reserved;
+		double extent[3];
+		boost::uint64_t nBranches;
+		boost::uint64_t nLeaves;
+	};
+	
+	/**
+	 * nodes of a model snapshot, in pre-order
+	 */
+	struct SnapshotStreams {
+		/** children mask followed by the mask of the children that are branches */
+		std::vector< unsigned char > branches;
+		/** inside corners */
+		std::vector< unsigned char > leaves;
+		
+		/** next record to be read */
+		std::size_t nextBranch, nextLeaf;
+		
+		SnapshotStreams() : nextBranch(0), nextLeaf(0) { }
+	};
 
 	/**
 	 * geometry and position of the cutter
@@ -52,18 +131,29 @@ private:
 		const Cutter::ConstPtr cutter;
 		const Eigen::Vector3d *extents;
 		const Eigen::Isometry3d *cutterIsom_model;
+		
+		/** inverse of cutterIsom_model: converts model points to cutter ones */
+		const Eigen::Isometry3d *modelIsom_cutter;
 		const Eigen::Isometry3d *bboxIsom_model;
 		const ShiftedBox::MinMaxMatrix *minMax;
 		
+		/** radii of the nodes at each depth tested with the separating axis
+		 * test and of the cutter bounding box, owned by the tester (see
+		 * IntersectionTester::buildSeparatingRadii)
+		 */
+		const ShiftedBox::SeparatingRadii *separatingRadii;
+		
 		CutterInfos(const Cutter::ConstPtr &cutter,
 				const Eigen::Vector3d *bboxExtents,
 				const Eigen::Isometry3d *cutterIsom_model,
+				const Eigen::Isometry3d *modelIsom_cutter,
 				const Eigen::Isometry3d *bboxIsom_model,
 				const ShiftedBox::MinMaxMatrix *minMax) :
 					cutter(cutter), extents(bboxExtents),
 					cutterIsom_model(cutterIsom_model),
+					modelIsom_cutter(modelIsom_cutter),
 					bboxIsom_model(bboxIsom_model),
-					minMax(minMax)
+					minMax(minMax), separatingRadii(NULL)
 		{
 		}
 		
@@ -73,15 +163,18 @@ private:
 	/**
 	 * @class DeletedDataQueuer
 	 *
-	 * internal class to manage deleted data, queuing them and processing at given pace
+	 * internal class to manage deleted data, queuing them and processing at given pace.
+	 * Data can be enqueued by more threads at the same time.
 	 */
 	class DeletedDataQueuer {
 	private:
 		typedef void (DeletedDataQueuer::* Queuer)(const VoxelInfo::Ptr &);
+		typedef boost::lock_guard< boost::mutex > LockGuard;
 		
 	private:
+		boost::mutex mutex;
 		StoredData::DeletedDataPtr deletedData;
-		int queuerIdx;
+		AtomicNumber< int, AtomicOrder::ACQ_REL > queuerIdx;
 		Queuer queuers[2];
 		
 	public:
@@ -105,7 +198,7 @@ private:
 		 * enable queuing
 		 */
 		void activate() {
-			queuerIdx = 1;
+			queuerIdx.set(1);
 		}
 		
 		/**
@@ -114,8 +207,9 @@ private:
 		 * @param data
 		 */
 		void enqueue(const VoxelInfo::Ptr &data) {
-			assert(queuerIdx < 2);
-			(this->*(queuers[queuerIdx]))(data);
+			int idx = queuerIdx.get();
+			assert(idx < 2);
+			(this->*(queuers[idx]))(data);
 		}
 		
 		/**
@@ -134,6 +228,8 @@ private:
 		}
 		
 		void realQueuer(const VoxelInfo::Ptr &data) {
+			Trace::Scope scope("deleted data queueing", "milling");
+			LockGuard l(mutex);
 			deletedData->push_back(data);
 		}
 	};
@@ -146,22 +242,41 @@ private:
 	class IntersectionTester {
 		
 	private:
-		typedef bool (IntersectionTester::* TestFoo)(const ShiftedBox &, const CutterInfos &) const;
+		typedef bool (IntersectionTester::* TestFoo)(const ShiftedBox &, unsigned int, const CutterInfos &) const;
 		
 	private:
 		static const int N_DIVISIONS = 2;
-		const unsigned int depthSwitch;
+		const unsigned int MAX_DEPTH;
+		
+		/** extents of the nodes at each depth */
+		std::vector< Eigen::Vector3d > cellSizes;
+		unsigned int depthSwitch;
 		TestFoo TESTS[N_DIVISIONS];
 		
+		/** separating radii of every pose of a pass, one for each depth,
+		 * allocated once and rebuilt by every pass
+		 */
+		std::vector< ShiftedBox::SeparatingRadii > radiiBuffer;
+		
 	public:
 		/**
 		 * constructor
 		 *
+		 * @param extent extent of the stock
 		 * @param maxDepth
+		 * @param depthSwitch first depth tested with the bounding box of
+		 * the cutter instead of the separating axis test
 		 */
-		IntersectionTester(unsigned int maxDepth) :
-			depthSwitch( std::min(4u, maxDepth) )
+		IntersectionTester(const Eigen::Vector3d &extent, unsigned int maxDepth, unsigned int depthSwitch) :
+			MAX_DEPTH(maxDepth), cellSizes(maxDepth + 1, extent),
+			depthSwitch( std::min(depthSwitch, maxDepth + 1) ),
+			radiiBuffer(MAX_POSES * (maxDepth + 1))
 		{
+			// same sizes of the tree geometry
+			for (unsigned int d = 1; d <= maxDepth; ++d) {
+				cellSizes[d] = cellSizes[d - 1] * 0.5;
+			}
+			
 			int i = 0;
 			TESTS[i++] = &IntersectionTester::accurateInt;
 			TESTS[i++] = &IntersectionTester::fastInt;
@@ -170,71 +285,272 @@ private:
 		
 		/**
 		 *
-		 * @param node
+		 * @return first depth tested with the bounding box of the cutter
+		 */
+		unsigned int getDepthSwitch() const {
+			return depthSwitch;
+		}
+		
+		/**
+		 * changes the first depth tested with the bounding box of the
+		 * cutter: it affects the radii built afterwards
+		 *
+		 * @param depthSwitch a depth deeper than the leaves tests all the
+		 * nodes with the separating axis test
+		 */
+		void setDepthSwitch(unsigned int depthSwitch) {
+			this->depthSwitch = std::min(depthSwitch, MAX_DEPTH + 1);
+		}
+		
+		/**
+		 * projects on the separating axes the radii of the cutter bounding
+		 * box and of the nodes at the depths tested with the separating
+		 * axis test, so that nodes only have to project their position.
+		 * Radii are kept by the tester until the same pose is built again.
+		 *
 		 * @param cutInfo
+		 * @param pose index of the pose in the pass, lower than MAX_POSES
+		 */
+		void buildSeparatingRadii(CutterInfos &cutInfo, unsigned int pose) {
+			assert(pose < MAX_POSES);
+			ShiftedBox::SeparatingRadii *radii = &radiiBuffer[pose * (MAX_DEPTH + 1)];
+			for (unsigned int d = 0; d < depthSwitch; ++d) {
+				ShiftedBox::calculateSeparatingRadii(cellSizes[d], *cutInfo.extents,
+						cutInfo.bboxIsom_model->linear(), radii[d]);
+			}
+			cutInfo.separatingRadii = radii;
+		}
+		
+		/**
+		 *
+		 * @param box box of the node to test
+		 * @param depth depth of the node to test
+		 * @param cutInfo radii have to be built (see #buildSeparatingRadii)
 		 * @return True if given node intersects the cutter
 		 */
-		bool isIntersecting(const OctreeNode::Ptr &node, const CutterInfos &cutInfo) const {
+		bool isIntersecting(const ShiftedBox &box, unsigned int depth, const CutterInfos &cutInfo) const {
 			/* choose the intersection test based upon tree depth: use more
 			 * accurate tests at higher levels and then switch to faster ones
 			 * when depth increase (and the number of leaves to analyze explode)
 			 */
-			int idx = node->getDepth() >= depthSwitch;
+			int idx = depth >= depthSwitch;
 			
 			assert(idx < N_DIVISIONS);
-			return (this->*(TESTS[idx]))(*node->getBox(), cutInfo);
+			return (this->*(TESTS[idx]))(box, depth, cutInfo);
 		}
 		
 	private:
-//		bool veryAccurateInt(const ShiftedBox &sbox, const CutterInfos &cutInfo) const {
-//			return sbox.isIntersecting(*cutInfo.extents, *cutInfo.bboxIsom_model, true);
+//		bool veryAccurateInt(const ShiftedBox &sbox, unsigned int depth, const CutterInfos &cutInfo) const {
+//			return sbox.isIntersecting(*cutInfo.bboxIsom_model, cutInfo.separatingRadii[depth], true);
 //		}
 		
-		bool accurateInt(const ShiftedBox &sbox, const CutterInfos &cutInfo) const {
-			return sbox.isIntersecting(*cutInfo.extents, *cutInfo.bboxIsom_model, false);
+		bool accurateInt(const ShiftedBox &sbox, unsigned int depth, const CutterInfos &cutInfo) const {
+			Trace::count(Trace::SAT_TESTS);
+			assert(depth < depthSwitch && cutInfo.separatingRadii);
+			return sbox.isIntersecting(*cutInfo.bboxIsom_model, cutInfo.separatingRadii[depth], false);
 		}
 		
-		bool fastInt(const ShiftedBox &sbox, const CutterInfos &cutInfo) const {
+		bool fastInt(const ShiftedBox &sbox, unsigned int, const CutterInfos &cutInfo) const {
+			Trace::count(Trace::AABB_TESTS);
 			return sbox.isIntersecting(*cutInfo.minMax);
 		}
 	};
 	
+	/**
+	 * @class DepthSwitchProfiler
+	 *
+	 * internal class choosing the depth switch of the IntersectionTester:
+	 * during the first passes that analyze some leaves every depth is tried
+	 * in turn, so that close moves are milled with each of them, and the
+	 * one whose tree descents took the least time is kept. Passes in the air
+	 * take next to no time whatever the depth, so they are not accounted.
+	 *
+	 * The depths are not equivalent: the separating axis test discards
+	 * nodes that the bounding box test keeps, and every kept leaf is
+	 * analyzed and possibly pushed. So the passes milled while profiling
+	 * and the chosen depth change the analyzed leaves (and in general the
+	 * waste and the model), and the choice depends on timings
+	 */
+	class DepthSwitchProfiler {
+		
+	private:
+		/** passes timed with each depth */
+		static const unsigned int ROUNDS = 16;
+		
+		std::vector< boost::chrono::nanoseconds > times;
+		unsigned int pass;
+		
+	public:
+		/**
+		 * constructor
+		 *
+		 * @param maxDepth the depths from 0 to maxDepth + 1 are tried
+		 * @param enabled if false no depth is tried
+		 */
+		DepthSwitchProfiler(unsigned int maxDepth, bool enabled) :
+			times(maxDepth + 2, boost::chrono::nanoseconds(0)),
+			pass(enabled ? 0 : ROUNDS * times.size())
+		{ }
+		
+		/**
+		 *
+		 * @return True while depths are being tried
+		 */
+		bool isProfiling() const {
+			return pass < ROUNDS * times.size();
+		}
+		
+		/**
+		 *
+		 * @return the depth to try in the next pass
+		 */
+		unsigned int getCandidate() const {
+			return pass % times.size();
+		}
+		
+		/**
+		 * accounts the time taken by the pass that tried the candidate
+		 *
+		 * @param time
+		 * @return True if it was the last pass of the profiling
+		 */
+		bool record(boost::chrono::nanoseconds time) {
+			times[getCandidate()] += time;
+			++pass;
+			
+			return !isProfiling();
+		}
+		
+		/**
+		 *
+		 * @return the depth that took the least time
+		 */
+		unsigned int getBest() const {
+			return std::min_element(times.begin(), times.end()) - times.begin();
+		}
+	};
+	
 	typedef Octree::VersionInfo VersionInfo;
 	
+	/**
+	 * i-th bit is set if i-th pose has to be tested against a node
+	 */
+	typedef boost::uint64_t PoseMask;
+	
+	/**
+	 * positions of the cutter processed in a single pass, in chronological
+	 * order
+	 */
 	struct RecursionInfo {
-		const CutterInfos &cutterInfo;
+		const boost::ptr_vector< CutterInfos > &cutterInfos;
+		
+		/** union of the bounding boxes of all poses */
+		const ShiftedBox::MinMaxMatrix &unionMinMax;
+		
 		const VersionInfo &vinfo;
-		IntersectionResult &results;
 		
-		RecursionInfo(const CutterInfos &cutterInfo,
+		/** one result for each pose */
+		IntersectionResult * const results;
+		
+		/** where changed leaves are logged, NULL if nobody reads them */
+		StoredData::VoxelData * const changes;
+		
+		/** branches above this depth process their children in parallel */
+		unsigned int splitDepth;
+		
+		/** index of the thread in the pool, that selects its node pools */
+		const unsigned int worker;
+		
+		RecursionInfo(const boost::ptr_vector< CutterInfos > &cutterInfos,
+				const ShiftedBox::MinMaxMatrix &unionMinMax,
 				const VersionInfo &vinfo,
-				IntersectionResult &results) :
-			cutterInfo(cutterInfo), vinfo(vinfo), results(results)
+				IntersectionResult *results,
+				StoredData::VoxelData *changes,
+				unsigned int splitDepth) :
+			cutterInfos(cutterInfos), unionMinMax(unionMinMax),
+			vinfo(vinfo), results(results), changes(changes),
+			splitDepth(splitDepth), worker(0)
+		{ }
+		
+		/**
+		 * copy of the given info for another thread, with another results
+		 * array and change log
+		 * @param other
+		 * @param results
+		 * @param changes
+		 * @param worker
+		 */
+		RecursionInfo(const RecursionInfo &other, IntersectionResult *results,
+				StoredData::VoxelData *changes, unsigned int worker) :
+			cutterInfos(other.cutterInfos), unionMinMax(other.unionMinMax),
+			vinfo(other.vinfo), results(results), changes(changes),
+			splitDepth(other.splitDepth), worker(worker)
 		{ }
+		
+		inline
+		unsigned int getPosesNumber() const {
+			return cutterInfos.size();
+		}
 	};
 
 	
-	typedef LeafNode::Ptr LeafPtr;
-	typedef void (Stock::* Processer)(OctreeNode::Ptr, RecursionInfo &recInfo);
-	
 	typedef boost::lock_guard< boost::mutex > LockGuard;
 	
-	typedef AtomicNumber<unsigned int> Versioner;
+	typedef AtomicNumber< unsigned int, AtomicOrder::ACQ_REL > Versioner;
 	
 private:
 	const unsigned int MAX_DEPTH;
 	const Eigen::Vector3d EXTENT;
 	const Eigen::Translation3d STOCK_MODEL_TRASLATION;
-	OctreeType MODEL;
-	const IntersectionTester intersectionTester;
+	boost::scoped_ptr< OctreeType > MODEL;
+	IntersectionTester intersectionTester;
+	
+	/** only the miller thread uses it */
+	DepthSwitchProfiler depthSwitchProfiler;
 	MesherType::Ptr MESHER;
 	unsigned int lastRetrievedVersion;
 	Versioner versioner;
 	
+	/* held by the miller while it modifies the model; the mesher never
+	 * waits for it, it only tries to acquire it to collect the changes
+	 * made while the miller is idle
+	 */
 	mutable boost::mutex mutex;
-	Processer PROCESSERS[2];
 	DeletedDataQueuer deletedQueuer;
 	
+	/** changes collected by the miller at the end of a pass for the mesher */
+	PtrHandoff< StoredData > meshingHandoff;
+	
+	/* leaves changed since the last collection, each one logged once
+	 * (see Octree::updateData): their corners are copied when the log is
+	 * collected
+	 */
+	StoredData::VoxelData changedLeaves;
+	
+	/** NULL if intersections are computed by a single thread */
+	boost::scoped_ptr< WorkStealingPool > POOL;
+	
+	/** depth, relative to the first processed branch, above which
+	 * branches process their children in parallel
+	 */
+	unsigned int SPLIT_DEPTH;
+	
+	/* deepest branch that contained the poses of the last pass: the next
+	 * descent starts there if it still contains the new poses (see
+	 * #processModel)
+	 */
+	MortonCode::CodeType descentStart;
+	
+	/* bounding box of the poses intersected since the last compaction:
+	 * only there new leaves can have been pushed (see #compact)
+	 */
+	Eigen::Vector3d compactMin, compactMax;
+	
+	/* last snapshot taken, until all of its slices are saved: the miller
+	 * saves the ones it is about to change
+	 */
+	mutable boost::weak_ptr< const Snapshot > pendingSnapshot;
+	
 public:
 	/**
 	 * constructor
@@ -242,8 +558,13 @@ public:
 	 * @param desc
 	 * @param maxDepth
 	 * @param mesher
+	 * @param nThreads number of threads used by #intersect
+	 * @param depthSwitch first depth whose nodes are tested with the
+	 * bounding box of the cutter instead of the separating axis test, or
+	 * AUTO_DEPTH_SWITCH
 	 */
-	Stock(const StockDescription &desc, unsigned int maxDepth, MesherType::Ptr mesher);
+	Stock(const StockDescription &desc, unsigned int maxDepth, MesherType::Ptr mesher,
+			unsigned int nThreads = 1, int depthSwitch = AUTO_DEPTH_SWITCH);
 	virtual ~Stock();
 	
 	/**
@@ -256,6 +577,46 @@ public:
 	 */
 	IntersectionResult intersect(const Cutter::ConstPtr &cutter, const Eigen::Isometry3d &rototrasl);
 	
+	/**
+	 * computes the intersections between Stock and Cutter placed in
+	 * consecutive poses descending the tree only once: results are the same
+	 * as calling #intersect for each pose in the given order.
+	 *
+	 * @param cutter
+	 * @param rototrasls rototraslations of the cutter in terms of this
+	 * stock basis, at most #MAX_POSES
+	 * @return one IntersectionResult for each pose: elapsed time of the
+	 * whole pass is evenly divided among them
+	 */
+	ResultList intersect(const Cutter::ConstPtr &cutter, const PoseList &rototrasls);
+	
+	/**
+	 * computes the intersection between Stock and the volume swept by
+	 * Cutter moving along a linear segment, keeping the orientation of
+	 * \c from
+	 * 
+	 * @param cutter a cutter supporting swept volumes
+	 * @param from rototraslation of the cutter at the beginning of the
+	 * segment, in terms of this stock basis
+	 * @param to rototraslation of the cutter at the end of the segment
+	 * @return
+	 */
+	IntersectionResult intersect(const Cutter::ConstPtr &cutter,
+			const Eigen::Isometry3d &from, const Eigen::Isometry3d &to);
+	
+	/**
+	 * computes the intersections between Stock and the volumes swept by
+	 * Cutter along a path of consecutive segments, descending the tree only
+	 * once
+	 * 
+	 * @param cutter a cutter supporting swept volumes
+	 * @param start rototraslation at the beginning of the path
+	 * @param rototrasls end of each segment, at most #MAX_POSES
+	 * @return one IntersectionResult for each segment
+	 */
+	ResultList intersectPath(const Cutter::ConstPtr &cutter,
+			const Eigen::Isometry3d &start, const PoseList &rototrasls);
+	
 	/**
 	 *
 	 * @return the resolution the milling is operating at
@@ -280,26 +641,320 @@ public:
 	 */
 	virtual Mesh::Ptr getMeshing();
 	
+	/**
+	 *
+	 * @return first depth whose nodes are tested with the bounding box of
+	 * the cutter (while it is being chosen, the one tried last)
+	 */
+	unsigned int getDepthSwitch() const;
+	
+	/**
+	 * walks the whole model: it waits for the running intersection, if any
+	 *
+	 * @return the number of nodes of the model
+	 */
+	NodesCount countNodes() const;
+	
+	/**
+	 * copy of the model taken by #takeSnapshot, that can be written while
+	 * the model is milled. Only the nodes above SNAPSHOT_SLICES_DEPTH are
+	 * copied when the snapshot is taken: the subtrees below (the slices) are
+	 * copied when the snapshot is written, or by the miller right before it
+	 * changes them, whichever comes first.
+	 */
+	class Snapshot : boost::noncopyable {
+		friend class Stock;
+		
+	public:
+		typedef boost::shared_ptr< const Snapshot > ConstPtr;
+		
+	private:
+		/**
+		 * consecutive nodes of the snapshot, in pre-order: a subtree below
+		 * SNAPSHOT_SLICES_DEPTH, or the nodes above it in between two of them
+		 */
+		struct Slice {
+			EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+			
+			enum State { SAVED, PENDING, SAVING };
+			
+			/** root of the subtree, while it is not saved */
+			BranchNode::ConstPtr branch;
+			
+			/** bounding box of the subtree */
+			ShiftedBox::MinMaxMatrix box;
+			
+			SnapshotStreams streams;
+			
+			/** guarded by Snapshot::mutex */
+			State state;
+			
+			Slice() : branch(NULL), state(SAVED) { }
+		};
+		
+		SnapshotHeader header;
+		mutable boost::ptr_vector< Slice > slices;
+		
+		/** slices still to be saved */
+		mutable AtomicNumber< unsigned int, AtomicOrder::ACQ_REL > pendingSlices;
+		
+		mutable boost::mutex mutex;
+		mutable boost::condition_variable sliceSaved;
+		
+	public:
+		Snapshot() : pendingSlices(0) { }
+		
+		/**
+		 * writes the snapshot: a header, then the children mask and the
+		 * mask of the children that are branches of every branch, then
+		 * the inside corners of every leaf, both in pre-order. The slices
+		 * not saved yet are saved first.
+		 *
+		 * @param os binary stream
+		 * @throw std::runtime_error if the snapshot cannot be written
+		 */
+		void write(std::ostream &os) const;
+		
+		/**
+		 * the slices not saved yet are saved first
+		 *
+		 * @return the number of bytes written by #write
+		 */
+		std::size_t getSize() const;
+		
+	private:
+		/**
+		 *
+		 * @return True if all the slices are saved
+		 */
+		bool isSaved() const {
+			return pendingSlices.get() == 0;
+		}
+		
+		/**
+		 * saves given slice, unless it is already saved: if another thread
+		 * is saving it, it waits for it
+		 * @param slice
+		 */
+		void saveSlice(Slice &slice) const;
+		
+		/**
+		 * saves all the slices
+		 */
+		void saveSlices() const;
+		
+		/**
+		 * saves the slices intersecting given region
+		 * @param region
+		 */
+		void saveSlices(const ShiftedBox::MinMaxMatrix &region) const;
+	};
+	
+	/**
+	 * copies the model at the last completed version: it waits for the
+	 * running intersection, if any. Only the top of the model is copied
+	 * here, the rest is copied later (see Snapshot): the model can go on
+	 * being milled meanwhile.
+	 *
+	 * The previous snapshot, if not fully saved yet, is saved first.
+	 *
+	 * @return the snapshot
+	 */
+	Snapshot::ConstPtr takeSnapshot() const;
+	
+	/**
+	 * rebuilds the model from a snapshot written by Snapshot::write. The
+	 * whole snapshot is read at once, then the tree is built in memory.
+	 *
+	 * @param is binary stream
+	 * @throw std::runtime_error if the model has already been milled or
+	 * meshed, or the snapshot is corrupted or was written by a stock with
+	 * different extent or max depth
+	 */
+	void loadModel(std::istream &is);
+	
+	/**
+	 * merges the branches whose children are 8 leaves with no inside
+	 * corner into a single leaf, as long as the merged leaves can be merged
+	 * in turn. Only the regions intersected since the last compaction are
+	 * visited. It waits for the running intersection, if any.
+	 *
+	 * The waste of later intersections is approximated: when a merged leaf
+	 * is split again, the corners found inside the cutter at that time are
+	 * inherited by its children as already cut, so they add no waste, while
+	 * the merged leaves would have accounted them. The waste can only be
+	 * lower than without compaction.
+	 *
+	 * @return the number of merged branches
+	 */
+	unsigned long compact();
+	
 private:
 	
+	/**
+	 * computes the intersections between Stock and given cutters, each one
+	 * placed in its own pose
+	 * @param cutters
+	 * @param rototrasls
+	 * @return
+	 */
+	ResultList intersect(const CutterList &cutters, const PoseList &rototrasls);
+	
 	/**
 	 * analyze leaf in order to detect whether it is intersecting the cutter partially or totally,
 	 * to perform the correct action (delete, expand, stop there since it can't be expanded any further).
 	 *
+	 * Poses are applied to the leaf in chronological order.
+	 *
 	 * @param currLeaf
+	 * @param poses poses intersecting the leaf
+	 * @param box box of the leaf
+	 * @param info
+	 * @param presetCorners if not NULL, corners of the leaf inside the
+	 * first pose of \c poses, already evaluated
+	 */
+	void analyzeLeaf(LeafNode::Ptr currLeaf, PoseMask poses,
+			const ShiftedBox &box, RecursionInfo &info,
+			const unsigned char *presetCorners);
+	
+	/**
+	 * processes the whole tree starting from the deepest branch that
+	 * contains the bounding box of all the poses: the branches above it are
+	 * not visited, they only discard the poses failing their intersection
+	 * test, so results are exactly the ones of a descent from the root. The
+	 * branch found by the previous pass is tried first, so that consecutive
+	 * poses do not descend again from the root
+	 * @param poses
 	 * @param info
 	 */
-	void analyzeLeaf(OctreeNode::Ptr currLeaf, RecursionInfo &info);
+	void processModel(PoseMask poses, RecursionInfo &info);
 	
 	/**
 	 * recursively process tree branches to find intersected leaves
 	 * @param branch
+	 * @param poses poses intersecting the branch
+	 * @param info
+	 * @param childrenCorners if not NULL, corners of each child inside the
+	 * first pose of \c poses (see #getChildrenCorners)
+	 */
+	void processTreeRecursive(BranchNode::Ptr branch, PoseMask poses,
+			RecursionInfo &info, const unsigned char *childrenCorners = NULL);
+	
+	/**
+	 * finds which of the given poses intersect the node and then, if any,
+	 * processes it
+	 * @param node
+	 * @param poses poses intersecting node father
 	 * @param info
+	 * @param presetCorners if not NULL and node is a leaf, its corners
+	 * inside the first pose of \c poses
+	 */
+	void processNode(OctreeNode::Ptr node, PoseMask poses,
+			RecursionInfo &info, const unsigned char *presetCorners = NULL);
+	
+	/**
+	 * processes the children of a branch as parallel tasks, each one
+	 * with its own results merged at the end into \c info.results
+	 * @param branch
+	 * @param children mask of the children to process
+	 * @param poses
+	 * @param info
+	 */
+	void processChildrenParallel(BranchNode::Ptr branch,
+			unsigned char children, PoseMask poses, RecursionInfo &info);
+	
+	/**
+	 * task body for #processChildrenParallel
+	 * @param node
+	 * @param poses
+	 * @param parentInfo
+	 * @param results where task results are accumulated
+	 * @param changes where task changes are logged (may be NULL)
+	 */
+	void processSubtree(OctreeNode::Ptr node, PoseMask poses,
+			const RecursionInfo &parentInfo, IntersectionResult *results,
+			StoredData::VoxelData *changes);
+	
+	/**
+	 * appends the leaf to the change log, if any
+	 * @param leaf
+	 * @param info
+	 */
+	void logChange(LeafNode::ConstPtr leaf, const RecursionInfo &info) const;
+	
+	/**
+	 * appends to the queue all the leaves of the subtree rooted in given
+	 * branch
+	 * @param node
+	 * @param queue
+	 */
+	void buildLeavesQueue(BranchNode::ConstPtr node, StoredData::VoxelData &queue) const;
+	
+	/**
+	 * counts the nodes of the subtree rooted in given branch, the branch
+	 * excluded
+	 * @param node
+	 * @param count
+	 */
+	void countNodes(BranchNode::ConstPtr node, NodesCount &count) const;
+	
+	/**
+	 * merges the uniform branches of the subtree rooted in given branch
+	 * (see #compact)
+	 * @param branch
+	 * @param region bounding box of the nodes to visit
+	 * @param vinfo
+	 * @param merged number of merged branches
+	 * @return True if the branch can be merged in turn
+	 */
+	bool compactSubtree(BranchNode::Ptr branch,
+			const ShiftedBox::MinMaxMatrix &region, const VersionInfo &vinfo,
+			unsigned long &merged);
+	
+	/**
+	 * appends the subtree rooted in given branch to the snapshot streams
+	 * @param branch
+	 * @param streams
 	 */
-	void processTreeRecursive(OctreeNode::Ptr branch, RecursionInfo &info);
+	static void saveSubtree(BranchNode::ConstPtr branch, SnapshotStreams &streams);
 	
-	void buildChangedNodesQueue(BranchNode::ConstPtr node,
-			const VersionInfo &vinfo, StoredData::VoxelData &queue) const;
+	/**
+	 * appends the subtree rooted in given branch to the last slice of the
+	 * snapshot, down to SNAPSHOT_SLICES_DEPTH: each branch there starts a
+	 * slice to be saved later, the following nodes go in a new slice
+	 * @param branch
+	 * @param snapshot
+	 */
+	void sliceSubtree(BranchNode::ConstPtr branch, Snapshot &snapshot) const;
+	
+	/**
+	 * saves the slices of the pending snapshot that intersect given
+	 * region: it must be called before changing the model there
+	 * @param region
+	 */
+	void saveSnapshotSlices(const ShiftedBox::MinMaxMatrix &region);
+	
+	/**
+	 * saves all the slices of the pending snapshot, if any: it must be
+	 * called before changing the model anywhere
+	 */
+	void completeSnapshot() const;
+	
+	/**
+	 * rebuilds the subtree rooted in given branch, whose children are still
+	 * the 8 leaves it was created with, reading the snapshot streams
+	 * @param branch
+	 * @param streams
+	 */
+	void loadSubtree(BranchNode::Ptr branch, SnapshotStreams &streams);
+	
+	/**
+	 * collects the leaves changed and deleted since the last collection
+	 * (the first time all the leaves are collected): the model must not be
+	 * modified in the meanwhile
+	 * @return the changes, to be deleted by the caller
+	 */
+	StoredData *collectChanges();
 	
 	struct WasteInfo {
 		int newInsideCorners;
@@ -311,25 +966,48 @@ private:
 	/**
 	 * delete a voxel
 	 *
-	 * @param leaf
-	 * @param cutterInfo
+	 * @param data data of the leaf
+	 * @param insideCorners corners of the leaf inside the cutter
 	 * @param wasteInfo
 	 */
-	void cutVoxel(const LeafPtr &leaf, const CutterInfos &cutterInfo, WasteInfo &wasteInfo) const;
+	void cutVoxel(const VoxelInfo::Ptr &data, unsigned char insideCorners,
+			WasteInfo &wasteInfo) const;
 	
 	/**
-	 * @param currLeaf
+	 *
+	 * @param box
+	 * @param cutterInfo
+	 * @return mask of the corners of the box inside the cutter
+	 */
+	unsigned char getInsideCorners(const ShiftedBox &box, const CutterInfos &cutterInfo) const;
+	
+	/**
+	 * The 8 children of a split leaf have 27 distinct corners: 8 of them are
+	 * the corners of the father, already tested and inherited by the
+	 * children (see VoxelInfo), so only the other 19 are tested here.
+	 *
+	 * @param fatherBox box of the split leaf
+	 * @param firstChildBox box of its child with index 0
+	 * @param cutterInfo
+	 * @param childrenCorners output masks of the corners of each child
+	 * inside the cutter, excluding the ones shared with the father
+	 */
+	void getChildrenCorners(const ShiftedBox &fatherBox, const ShiftedBox &firstChildBox,
+			const CutterInfos &cutterInfo, unsigned char childrenCorners[]) const;
+	
+	/**
+	 * @param box box of the leaf the waste refers to
 	 * @param info
 	 * @return amount of material to be removed
 	 */
-	double calculateNewWaste(const LeafPtr &currLeaf, const WasteInfo &info);
+	double calculateNewWaste(const ShiftedBox &box, const WasteInfo &info);
 	
 	/**
 	 *
-	 * @param leaf
+	 * @param depth depth of the leaf
 	 * @return True if branch can be furtherly expanded, False if minimum voxel size has been reached
 	 */
-	bool canPushLevel(const LeafPtr &leaf) const;
+	bool canPushLevel(unsigned int depth) const;
 	
 	friend std::ostream & operator<<(std::ostream &os, const Stock &stock);
 };
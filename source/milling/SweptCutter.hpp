@@ -0,0 +1,127 @@
+/**
+ * SweptCutter.hpp
+ *
+ *  Created on: 17/ott/2026
+ *      Author: socket
+ */
+
+#ifndef SWEPTCUTTER_HPP_
+#define SWEPTCUTTER_HPP_
+
+#include <ostream>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+
+#include <Eigen/Geometry>
+
+#include <osg/Group>
+#include <osg/PositionAttitudeTransform>
+
+#include "Cutter.hpp"
+
+/**
+ * @class SweptCutter
+ *
+ * Volume swept by a cutter moving along a linear segment: it is placed as
+ * the cutter at the beginning of the segment and its distances are the
+ * ones of the whole swept volume, so that stock can be intersected with a
+ * segment exactly as it is intersected with a single pose.
+ *
+ * Cutter orientation is kept constant along the segment.
+ */
+class SweptCutter : public Cutter {
+
+public:
+	typedef boost::shared_ptr< SweptCutter > Ptr;
+	typedef boost::shared_ptr< const SweptCutter > ConstPtr;
+
+private:
+	const Cutter::ConstPtr CUTTER;
+	
+	/** translation from the beginning to the end of the segment, in cutter basis */
+	const Eigen::Vector3d MOVEMENT;
+
+public:
+	/**
+	 * constructor
+	 * @param cutter
+	 * @param movement translation of the cutter along the segment,
+	 * expressed in cutter basis
+	 */
+	SweptCutter(const Cutter::ConstPtr &cutter, const Eigen::Vector3d &movement) :
+		Cutter(cutter->getColor()), CUTTER(cutter), MOVEMENT(movement)
+	{ }
+	
+	virtual ~SweptCutter() { }
+	
+	/**
+	 *
+	 * @param point in basis of the cutter at the beginning of the segment
+	 * @return
+	 */
+	virtual double getDistance(const Eigen::Vector3d &point) const {
+		return CUTTER->getSweptDistance(point, MOVEMENT);
+	}
+	
+	/**
+	 * box of the cutter at the beginning of the segment stretched along
+	 * its axes in order to contain the box at the end of the segment
+	 * @return
+	 */
+	virtual BoundingBoxInfo getBoundingBox() const {
+		BoundingBoxInfo info = CUTTER->getBoundingBox();
+		
+		Eigen::Vector3d bboxMovement = info.rototraslation.linear().transpose() * MOVEMENT;
+		info.extents += bboxMovement.cwiseAbs();
+		info.rototraslation = info.rototraslation * Eigen::Translation3d(bboxMovement * 0.5);
+		
+		return info;
+	}
+	
+	virtual std::ostream & toOutStream(std::ostream &os) const {
+		os << "SWEPT(" << *CUTTER << "; movement=" << MOVEMENT.transpose() << ")";
+		
+		return os;
+	}
+	
+	/**
+	 *
+	 * @return the mesh of the cutter at both ends of the segment
+	 */
+	virtual Mesh::Ptr getMeshing() {
+		// cutters only cache their mesh, their shape never changes
+		osg::ref_ptr< osg::Node > cutterMesh =
+				boost::const_pointer_cast< Cutter >(CUTTER)->getMeshing()->getMesh();
+		
+		osg::ref_ptr< osg::Group > group = new osg::Group;
+		group->addChild(cutterMesh.get());
+		
+		osg::ref_ptr< osg::PositionAttitudeTransform > end = new osg::PositionAttitudeTransform;
+		end->setPosition(osg::Vec3d(MOVEMENT.x(), MOVEMENT.y(), MOVEMENT.z()));
+		end->addChild(cutterMesh.get());
+		group->addChild(end.get());
+		
+		return boost::make_shared< Mesh >(group.get());
+	}
+	
+	/**
+	 * builds the volume swept by the cutter moving from a pose to another
+	 * one
+	 * @param cutter
+	 * @param from pose at the beginning of the segment
+	 * @param to pose at the end of the segment
+	 * @return
+	 */
+	static Cutter::ConstPtr buildSegment(const Cutter::ConstPtr &cutter,
+			const Eigen::Isometry3d &from, const Eigen::Isometry3d &to) {
+		
+		Eigen::Vector3d movement = from.linear().transpose() * (to.translation() - from.translation());
+		if (movement.isZero(0))
+			return cutter;
+		
+		return boost::make_shared< SweptCutter >(cutter, movement);
+	}
+};
+
+#endif /* SWEPTCUTTER_HPP_ */
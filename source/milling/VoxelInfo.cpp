@@ -17,6 +17,21 @@ VoxelInfo::VoxelInfo(double val) {
 	}
 }
 
+VoxelInfo::VoxelInfo(const VoxelInfo &father, unsigned char childIdx) {
+	
+	// corner of each child that lies on the same corner of the father
+	static const Corner::CornerType SHARED_CORNER[] = {
+		Corner::BottomFrontLeft, Corner::UpperFrontLeft,
+		Corner::BottomRearLeft, Corner::UpperRearLeft,
+		Corner::BottomFrontRight, Corner::UpperFrontRight,
+		Corner::BottomRearRight, Corner::UpperRearRight
+	};
+	
+	assert(childIdx < 8);
+	
+	insideCorners = father.insideCorners & (0x01 << SHARED_CORNER[childIdx]);
+}
+
 VoxelInfo::~VoxelInfo() {
 	
 }
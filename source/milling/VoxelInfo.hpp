@@ -14,6 +14,7 @@
 #include <boost/shared_ptr.hpp>
 
 #include "common/Utilities.hpp"
+#include "SharedPool.hpp"
 #include "Corner.hpp"
 #include "graphics_info.hpp"
 
@@ -28,6 +29,9 @@ public:
 	typedef boost::shared_ptr< VoxelInfo > Ptr;
 	typedef boost::shared_ptr< const VoxelInfo > ConstPtr;
 	
+	/** allocator for boost::allocate_shared, upon a pool of the tree */
+	typedef PoolAllocator< VoxelInfo > Allocator;
+	
 private:
 	// updated by updateInsideness(unsigned char, double) function
 	unsigned char insideCorners;
@@ -41,6 +45,17 @@ public:
 	 */
 	VoxelInfo(double val);
 	
+	/**
+	 * constructor for the voxels created by the split of a father voxel:
+	 * the only corner shared with the father inherits its insideness, so
+	 * that material already removed is not accounted again
+	 * 
+	 * @param father
+	 * @param childIdx index of the child inside the father (bit 2 selects
+	 * the X half, bit 1 the Y half and bit 0 the Z half)
+	 */
+	VoxelInfo(const VoxelInfo &father, unsigned char childIdx);
+	
 	/**
 	 * destructor
 	 */
@@ -65,6 +80,15 @@ public:
 		return insideCorners == 0xff;
 	}
 	
+	/**
+	 *
+	 * @return mask of the corners inside the cutter (see Corner::CornerType)
+	 */
+	inline
+	unsigned char getInsideCorners() const {
+		return insideCorners;
+	}
+	
 	/**
 	 *
 	 * @param c corner to check
@@ -110,6 +134,20 @@ public:
 		return oldInside ^ insideCorners;
 	}
 	
+	/**
+	 * 
+	 * @param corners mask of the corners now inside
+	 * @return mask of the corners that were previously outside but now are
+	 * inside
+	 */
+	inline
+	unsigned char updateInsideCorners(unsigned char corners) {
+		unsigned char newInside = corners & ~insideCorners;
+		insideCorners |= corners;
+		
+		return newInside;
+	}
+	
 	/**
 	 * overrides << operator
 	 * @param os
@@ -26,6 +26,7 @@
 
 #include "configuration/CutterDescription.hpp"
 #include "common/Utilities.hpp"
+#include "common/SimdDouble.hpp"
 #include "visualizer/VisualizationUtils.hpp"
 
 /**
@@ -81,6 +82,53 @@ public:
 		return SQUARE_RADIUS - point.squaredNorm();
 	}
 	
+	/**
+	 * vectorized version of #getDistance: a corner is inside if its
+	 * squared norm does not exceed the squared radius
+	 * 
+	 * @param corners
+	 * @return
+	 */
+	virtual unsigned char getInsideCorners(const CornerCoords &corners) const {
+		typedef SimdDouble SD;
+		
+		const SD::Vector squareRadius = SD::set(SQUARE_RADIUS);
+		
+		int inside = 0;
+		for (int c = 0; c < Corner::N_CORNERS; c += SD::WIDTH) {
+			SD::Vector x = SD::load(corners.x + c);
+			SD::Vector y = SD::load(corners.y + c);
+			SD::Vector z = SD::load(corners.z + c);
+			
+			SD::Vector squaredNorm = SD::add(SD::add(SD::mul(x, x), SD::mul(y, y)), SD::mul(z, z));
+			
+			inside |= SD::lessEqual(squaredNorm, squareRadius) << c;
+		}
+		
+		return inside;
+	}
+	
+	/**
+	 * the swept volume is a capsule: distance is measured from the point of
+	 * the movement nearest to \c point
+	 * 
+	 * @param point
+	 * @param movement
+	 * @return
+	 */
+	virtual double getSweptDistance(const Eigen::Vector3d &point,
+			const Eigen::Vector3d &movement) const {
+		
+		double squaredLength = movement.squaredNorm();
+		if (squaredLength <= std::numeric_limits<double>::epsilon())
+			return getDistance(point);
+		
+		double t = point.dot(movement) / squaredLength;
+		t = std::min(1.0, std::max(0.0, t));
+		
+		return SQUARE_RADIUS - (point - t * movement).squaredNorm();
+	}
+	
 	virtual std::ostream & toOutStream(std::ostream &os) const {
 		os << "SPHERE(diameter=" << this->DIAMETER << ")";
 		
@@ -204,6 +252,88 @@ public:
 		return -secondTerm;
 	}
 	
+	/**
+	 * vectorized version of #getDistance: a corner is inside if it is
+	 * between the bases (both included) and its radial distance does not
+	 * exceed the radius
+	 * 
+	 * @param corners
+	 * @return
+	 */
+	virtual unsigned char getInsideCorners(const CornerCoords &corners) const {
+		typedef SimdDouble SD;
+		
+		const SD::Vector zero = SD::set(0);
+		const SD::Vector halfLength = SD::set(HALF_LENGTH);
+		const SD::Vector radius = SD::set(RADIUS);
+		
+		int inside = 0;
+		for (int c = 0; c < Corner::N_CORNERS; c += SD::WIDTH) {
+			SD::Vector x = SD::load(corners.x + c);
+			SD::Vector y = SD::load(corners.y + c);
+			SD::Vector z = SD::load(corners.z + c);
+			
+			SD::Vector firstTerm = SD::sub(SD::abs(SD::sub(z, halfLength)), halfLength);
+			SD::Vector secondTerm = SD::add(SD::mul(x, x),
+					SD::mul(SD::add(y, radius), SD::sub(y, radius)));
+			
+			int onBases = SD::equal(firstTerm, zero);
+			int betweenBases = SD::less(firstTerm, zero);
+			int insideRadius = SD::lessEqual(secondTerm, zero);
+			
+			inside |= (onBases | (betweenBases & insideRadius)) << c;
+		}
+		
+		return inside;
+	}
+	
+	/**
+	 * \c point is inside the swept volume if the cutter contains it at
+	 * least for one t in [0, 1] when translated by t * movement: the height
+	 * constraint bounds t to an interval where the radial distance, which is
+	 * quadratic in t, is minimized.
+	 * 
+	 * @param point
+	 * @param movement
+	 * @return
+	 */
+	virtual double getSweptDistance(const Eigen::Vector3d &point,
+			const Eigen::Vector3d &movement) const {
+		
+		// interval of t keeping point(2) - t * movement(2) in [0, LENGTH]
+		double tMin = 0, tMax = 1;
+		if (fabs(movement[2]) <= std::numeric_limits<double>::epsilon()) {
+			if (point[2] < 0 || point[2] > LENGTH)
+				return -(fabs(point[2] - HALF_LENGTH) - HALF_LENGTH);
+		} else {
+			double tBottom = point[2] / movement[2];
+			double tTop = (point[2] - LENGTH) / movement[2];
+			tMin = std::max(tMin, std::min(tBottom, tTop));
+			tMax = std::min(tMax, std::max(tBottom, tTop));
+			
+			if (tMin > tMax) {
+				// height is never reached: use the nearest position
+				double t = (point[2] - HALF_LENGTH) / movement[2];
+				t = std::min(1.0, std::max(0.0, t));
+				
+				return -(fabs(point[2] - t * movement[2] - HALF_LENGTH) - HALF_LENGTH);
+			}
+		}
+		
+		double squaredPlanar = boost::math::pow< 2 >(movement[0])
+				+ boost::math::pow< 2 >(movement[1]);
+		double t = tMin;
+		if (squaredPlanar > std::numeric_limits<double>::epsilon()) {
+			t = (point[0] * movement[0] + point[1] * movement[1]) / squaredPlanar;
+			t = std::min(tMax, std::max(tMin, t));
+		}
+		
+		double x = point[0] - t * movement[0];
+		double y = point[1] - t * movement[1];
+		
+		return -(boost::math::pow< 2 >(x) + (y + RADIUS) * (y - RADIUS));
+	}
+	
 	virtual std::ostream & toOutStream(std::ostream &os) const {
 		os << "CYLINDER(diameter=" << this->DIAMETER << "; height=" << this->LENGTH << ")";
 		
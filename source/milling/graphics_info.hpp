@@ -14,12 +14,18 @@
 
 #include <osg/Node>
 
+#include "Corner.hpp"
 #include "ShiftedBox.hpp"
 
 class VoxelInfo;
 
 /**
  * data (voxel+infos) to be displayed
+ *
+ * vinfo is shared with the miller, that keeps cutting while the mesher
+ * works: the mesher only uses it to bind its graphics, while the voxel
+ * shape is read from insideCorners, a copy taken when the data was
+ * collected so that all the voxels of a mesh belong to the same version
  */
 struct GraphicData {
 	typedef std::list< GraphicData > List;
@@ -27,12 +33,31 @@ struct GraphicData {
 	typedef boost::shared_ptr< VoxelInfo > VoxelInfoPtr;
 	
 	
-	GraphicData(const ShiftedBox::ConstPtr &sbox, const VoxelInfoPtr &vinfo) :
-		sbox(sbox), vinfo(vinfo) { }
+	GraphicData(const ShiftedBox::ConstPtr &sbox, const VoxelInfoPtr &vinfo,
+			unsigned char insideCorners) :
+		sbox(sbox), vinfo(vinfo), insideCorners(insideCorners) { }
 	virtual ~GraphicData() { }
 	
+	/**
+	 *
+	 * @return true if at least one corner was cut
+	 */
+	bool isIntersecting() const {
+		return insideCorners > 0;
+	}
+	
+	/**
+	 *
+	 * @param c
+	 * @return true if given corner was cut
+	 */
+	bool isCornerCut(Corner::CornerType c) const {
+		return insideCorners & (0x01 << static_cast< int >(c));
+	}
+	
 	ShiftedBox::ConstPtr sbox;
 	VoxelInfoPtr vinfo;
+	unsigned char insideCorners;
 };
 
 /**
@@ -13,20 +13,24 @@
 #include <stdexcept>
 
 #include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
 #include <boost/array.hpp>
 
 #include <Eigen/Geometry>
 
+#include "common/AtomicNumber.hpp"
 #include "common/Point3D.hpp"
 #include "common/Utilities.hpp"
-#include "ShiftedBox.hpp"
+#include "MortonCode.hpp"
 #include "Adjacencies.hpp"
 #include "VoxelInfo.hpp"
 
 /**
  * @class OctreeNode
  *
- * defines a node of the octree
+ * defines a node of the octree. A node does not store its own box: its
+ * geometry is implicitly given by its locational code (see MortonCode) and
+ * depth, and can be asked to the Octree it belongs to.
  */
 class OctreeNode {
 	
@@ -51,50 +55,59 @@ public:
 	};
 	
 private:
+#ifdef OCTREE_NODE_IDS
 	struct NodeIDs {
 		static unsigned long getNodeID() {
-			static AtomicNumber< unsigned long > IDs;
+			// IDs only have to be unique
+			static AtomicNumber< unsigned long, AtomicOrder::RELAXED > IDs;
 			return IDs.getAndInc();
 		}
 	};
+#endif
 	
 	const OctreeNode::Ptr father;
-	const unsigned char childIdx;
-	const ShiftedBox::ConstPtr sbox;
+	const MortonCode::CodeType CODE;
+#ifdef OCTREE_NODE_IDS
 	const unsigned long NODE_ID;
-	const unsigned int DEPTH;
+#endif
 	
 	unsigned int firstChangeVersion;
+	const unsigned char DEPTH;
 	
 public:
 	/**
-	 * constructor
-	 * @param box
+	 * constructor for the root node
 	 * @param vinfo
 	 */
-	OctreeNode(const ShiftedBox::ConstPtr &box, const VersionInfo &vinfo) :
-		father(), childIdx(255), sbox(box), NODE_ID(NodeIDs::getNodeID()),
-		DEPTH(0), firstChangeVersion(vinfo.currVersion)
+	OctreeNode(const VersionInfo &vinfo) :
+		father(), CODE(MortonCode::ROOT),
+#ifdef OCTREE_NODE_IDS
+		NODE_ID(NodeIDs::getNodeID()),
+#endif
+		firstChangeVersion(vinfo.currVersion), DEPTH(0)
 	{ }
 	
 	/**
 	 * constructor
 	 * @param father
 	 * @param childIdx
-	 * @param sbox
 	 * @param vinfo
 	 */
 	OctreeNode(const OctreeNode::Ptr &father, unsigned char childIdx,
-			const ShiftedBox::ConstPtr &sbox, const VersionInfo &vinfo) :
-			father(father), childIdx(childIdx), sbox(sbox),
-			NODE_ID(NodeIDs::getNodeID()), DEPTH(father->getDepth() + 1),
-			firstChangeVersion(vinfo.currVersion)
+			const VersionInfo &vinfo) :
+			father(father), CODE(MortonCode::child(father->getCode(), childIdx)),
+#ifdef OCTREE_NODE_IDS
+			NODE_ID(NodeIDs::getNodeID()),
+#endif
+			firstChangeVersion(vinfo.currVersion), DEPTH(father->getDepth() + 1)
 	{
 		
 		if (father == NULL)
 			throw std::invalid_argument("Given father cannot be null");
 		if (childIdx >= 8)
 			throw std::invalid_argument("Given childIdx must be in [0, 7]");
+		if (father->getDepth() >= MortonCode::MAX_DEPTH)
+			throw std::invalid_argument("Given father is too deep");
 	}
 	
 	/**
@@ -136,16 +149,16 @@ public:
 		assert(!isRoot());
 			// throw std::runtime_error("cannot ask root's childIdx");
 		
-		return this->childIdx;
+		return MortonCode::childIdx(this->CODE);
 	}
 	
 	/**
 	 *
-	 * @return the ShiftedBox of the node
+	 * @return locational code of the node
 	 */
 	inline
-	const ShiftedBox::ConstPtr & getBox() const {
-		return this->sbox;
+	MortonCode::CodeType getCode() const {
+		return this->CODE;
 	}
 	
 	/**
@@ -158,31 +171,34 @@ public:
 	}
 	
 	/**
+	 * IDs are unique among all the nodes ever created only when
+	 * OCTREE_NODE_IDS is defined, otherwise the locational code is used,
+	 * which is unique among the nodes of the same tree
 	 *
 	 * @return ID of the node
 	 */
 	inline
 	unsigned long getID() const {
+#ifdef OCTREE_NODE_IDS
 		return this->NODE_ID;
+#else
+		return this->CODE;
+#endif
 	}
 	
 	/**
 	 * set first change version
 	 * @param vinfo
+	 * @return \c false if the node was already changed in the current version
 	 */
-	void setFirstChangeVersion(const VersionInfo &vinfo) {
+	bool setFirstChangeVersion(const VersionInfo &vinfo) {
 		if (isChanged(vinfo)) {
 			// we already set our 'first change' version
-			return;
+			return false;
 		}
 		
 		firstChangeVersion = vinfo.currVersion;
-		
-		if (isRoot()) {
-			return;
-		} else {
-			getFather()->setFirstChangeVersion(vinfo);
-		}
+		return true;
 	}
 	
 	/**
@@ -252,6 +268,16 @@ public:
 public:
 	static const int N_CHILDREN = 8;
 	
+	/**
+	 * children of a branch can be set and deleted by different threads at
+	 * the same time, as long as each thread changes different children
+	 */
+#if defined(__GNUC__) && defined(__ATOMIC_RELAXED)
+	static const bool ATOMIC_CHILDREN = true;
+#else
+	static const bool ATOMIC_CHILDREN = false;
+#endif
+	
 private:
 	boost::array< OctreeNode::Ptr, N_CHILDREN > children;
 	
@@ -264,32 +290,26 @@ private:
 public:
 	/**
 	 * constructor
-	 * @param box
 	 * @param vinfo
 	 */
-	BranchNode(const ShiftedBox::ConstPtr &box, const VersionInfo &vinfo) :
-		OctreeNode(box, vinfo)
+	BranchNode(const VersionInfo &vinfo) :
+		OctreeNode(vinfo)
 	{ initChildren(); }
 	
 	/**
 	 * constructor
 	 * @param father
 	 * @param childIdx
-	 * @param sbox
 	 * @param vinfo
 	 */
-	BranchNode(OctreeNode::Ptr father, unsigned char childIdx, const ShiftedBox::ConstPtr &sbox, const VersionInfo &vinfo) :
-		OctreeNode(father, childIdx, sbox, vinfo) { initChildren(); }
+	BranchNode(OctreeNode::Ptr father, unsigned char childIdx, const VersionInfo &vinfo) :
+		OctreeNode(father, childIdx, vinfo) { initChildren(); }
 	
 	/**
-	 * destructor
+	 * destructor: children are not destroyed here because their memory
+	 * belongs to the Octree that created them
 	 */
-	virtual ~BranchNode() {
-		for (int i = 0; i < N_CHILDREN; i++) {
-			if (hasChild(i))
-				delete children[i];
-		}
-	}
+	virtual ~BranchNode() { }
 	
 	/**
 	 *
@@ -308,7 +328,17 @@ public:
 	inline
 	bool hasChild(int i) const {
 		assert(i >= 0 && i < N_CHILDREN);
-		return childrenMask & (0x01 << i);
+		return loadChildrenMask() & (0x01 << i);
+	}
+	
+	/**
+	 *
+	 * @return mask of the existing children: i-th bit is set if i-th child
+	 * is present
+	 */
+	inline
+	unsigned char getChildrenMask() const {
+		return loadChildrenMask();
 	}
 	
 	/**
@@ -328,7 +358,7 @@ public:
 	 */
 	inline
 	bool isEmpty() const {
-		return !childrenMask;
+		return !loadChildrenMask();
 	}
 	
 	/**
@@ -341,7 +371,14 @@ public:
 	void deleteChild(int i) {
 		assert(hasChild(i));
 		
+#if defined(__GNUC__) && defined(__ATOMIC_RELAXED)
+		/* siblings may be changed by other threads: their changes are
+		 * published by the synchronization that joins the threads
+		 */
+		__atomic_fetch_and(&childrenMask, (unsigned char)~(0x01 << i), __ATOMIC_RELAXED);
+#else
 		childrenMask &= ~(0x01 << i);
+#endif
 		children[i] = NULL;
 	}
 	
@@ -354,7 +391,11 @@ public:
 	void setChild(int i, const OctreeNode::Ptr &child) {
 		assert(!hasChild(i));
 		
+#if defined(__GNUC__) && defined(__ATOMIC_RELAXED)
+		__atomic_fetch_or(&childrenMask, (unsigned char)(0x01 << i), __ATOMIC_RELAXED);
+#else
 		childrenMask |= (0x01 << i);
+#endif
 		(this->children)[i] = child;
 	}
 	
@@ -441,6 +482,20 @@ private:
 	void initChildren() {
 		childrenMask = 0x00;
 	}
+
+	/**
+	 *
+	 * @return the children mask, that other threads may be changing
+	 * (see #deleteChild)
+	 */
+	inline
+	unsigned char loadChildrenMask() const {
+#if defined(__GNUC__) && defined(__ATOMIC_RELAXED)
+		return __atomic_load_n(&childrenMask, __ATOMIC_RELAXED);
+#else
+		return childrenMask;
+#endif
+	}
 };
 
 /**
@@ -455,18 +510,17 @@ public:
 	typedef const LeafNode * ConstPtr;
 	
 private:
-	unsigned char cuttedVertex;
 	VoxelInfo::Ptr voxelInfo;
 	
 public:
 	/**
 	 * constructor
 	 *
-	 * @param box
 	 * @param vinfo
 	 */
-	LeafNode(const ShiftedBox::ConstPtr &box, const VersionInfo &vinfo) :
-			OctreeNode(box, vinfo)
+	LeafNode(const VersionInfo &vinfo) :
+			OctreeNode(vinfo),
+			voxelInfo(boost::make_shared< VoxelInfo >(VoxelInfo::DEFAULT_INSIDENESS()))
 	{
 	}
 	
@@ -475,13 +529,30 @@ public:
 	 *
 	 * @param father
 	 * @param childIdx
-	 * @param sbox
 	 * @param vinfo
+	 * @param alloc allocator of the data
+	 */
+	LeafNode(const OctreeNode::Ptr &father, unsigned char childIdx,
+			const VersionInfo &vinfo, const VoxelInfo::Allocator &alloc) :
+				OctreeNode(father, childIdx, vinfo),
+				voxelInfo(boost::allocate_shared< VoxelInfo >(alloc, VoxelInfo::DEFAULT_INSIDENESS()))
+	{
+	}
+	
+	/**
+	 * constructor for the children of a split leaf
+	 *
+	 * @param father
+	 * @param childIdx
+	 * @param vinfo
+	 * @param fatherData data of the split leaf
+	 * @param alloc allocator of the data
 	 */
 	LeafNode(const OctreeNode::Ptr &father, unsigned char childIdx,
-			const ShiftedBox::ConstPtr &sbox, const VersionInfo &vinfo) :
-				OctreeNode(father, childIdx, sbox, vinfo),
-				voxelInfo(boost::make_shared< VoxelInfo >(VoxelInfo::DEFAULT_INSIDENESS()))
+			const VersionInfo &vinfo, const VoxelInfo &fatherData,
+			const VoxelInfo::Allocator &alloc) :
+				OctreeNode(father, childIdx, vinfo),
+				voxelInfo(boost::allocate_shared< VoxelInfo >(alloc, fatherData, childIdx))
 	{
 	}
 	
@@ -503,7 +574,7 @@ public:
 	 *
 	 * @return the VoxelInfos
 	 */
-	VoxelInfo::Ptr getData() {
+	VoxelInfo::Ptr getData() const {
 		return this->voxelInfo;
 	}
 	
@@ -21,7 +21,8 @@
 class CyclicRunnable: public Runnable {
 	
 private:
-	AtomicNumber<unsigned long> cycleCounter;
+	// only read as a statistic: no ordering with other memory is needed
+	AtomicNumber< unsigned long, AtomicOrder::RELAXED > cycleCounter;
 	
 protected:
 	virtual bool hasNextCycle() throw() =0;
@@ -0,0 +1,157 @@
+/**
+ * WorkStealingPool.cpp
+ *
+ *  Created on: 17/ott/2026
+ *      Author: socket
+ */
+
+#include "WorkStealingPool.hpp"
+
+#include <stdexcept>
+
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include "common/Trace.hpp"
+
+WorkStealingPool::WorkStealingPool(unsigned int nThreads, const std::string &name) :
+	queued(0), stopping(false)
+{
+	if (nThreads == 0)
+		throw std::invalid_argument("thread number should be >0");
+
+	for (unsigned int i = 0; i < nThreads; ++i) {
+		queues.push_back(new TaskQueue());
+	}
+
+	// queue 0 is left to the caller
+	for (unsigned int i = 1; i < nThreads; ++i) {
+		threads.create_thread(boost::bind(&WorkStealingPool::workerLoop, this, i, name));
+	}
+}
+
+WorkStealingPool::~WorkStealingPool() {
+	{
+		LockGuard l(sleepMutex);
+		stopping = true;
+		wakeUp.notify_all();
+	}
+
+	threads.join_all();
+}
+
+unsigned int WorkStealingPool::getThreadsNumber() const {
+	return queues.size();
+}
+
+void WorkStealingPool::submit(TaskGroup &group, const Task &task) {
+	group.pending.incAndGet();
+
+	TaskQueue &queue = queues[getThreadIdx()];
+	{
+		LockGuard l(queue.mutex);
+		queue.tasks.push_back(Entry(task, &group));
+	}
+
+	queued.incAndGet();
+	{
+		LockGuard l(sleepMutex);
+		wakeUp.notify_one();
+	}
+}
+
+void WorkStealingPool::wait(TaskGroup &group) {
+	unsigned int idx = getThreadIdx();
+
+	while (group.pending.get() > 0) {
+		if (runTask(idx)) {
+			continue;
+		}
+		
+		// remaining tasks are being executed by other threads
+		UniqueLock l(sleepMutex);
+		while (group.pending.get() > 0 && queued.get() == 0) {
+			wakeUp.wait(l);
+		}
+	}
+
+	if (group.failed.get() > 0) {
+		boost::rethrow_exception(group.error);
+	}
+}
+
+unsigned int WorkStealingPool::getThreadIdx() const {
+	unsigned int *idx = queueIdx.get();
+	return (idx == NULL) ? 0 : *idx;
+}
+
+bool WorkStealingPool::runTask(unsigned int idx) {
+	Entry entry;
+	bool found = false;
+
+	// newest task of own queue first...
+	{
+		TaskQueue &own = queues[idx];
+		LockGuard l(own.mutex);
+		if (!own.tasks.empty()) {
+			entry = own.tasks.back();
+			own.tasks.pop_back();
+			found = true;
+		}
+	}
+
+	// ...otherwise steal the oldest one from the others
+	for (unsigned int i = 1; !found && i < queues.size(); ++i) {
+		TaskQueue &victim = queues[(idx + i) % queues.size()];
+		LockGuard l(victim.mutex);
+		if (!victim.tasks.empty()) {
+			entry = victim.tasks.front();
+			victim.tasks.pop_front();
+			found = true;
+		}
+	}
+
+	if (!found) {
+		return false;
+	}
+
+	queued.decAndGet();
+
+	TaskGroup &group = *entry.second;
+	try {
+		entry.first();
+	} catch (...) {
+		// the error is published by the decrement of pending
+		if (group.failed.getAndAdd(1) == 0) {
+			group.error = boost::current_exception();
+		}
+	}
+
+	if (group.pending.decAndGet() == 0) {
+		// the waiting thread may be sleeping
+		LockGuard l(sleepMutex);
+		wakeUp.notify_all();
+	}
+
+	return true;
+}
+
+void WorkStealingPool::workerLoop(unsigned int idx, const std::string &name) {
+	queueIdx.reset(new unsigned int(idx));
+	Trace::nameThread(name + " " + boost::lexical_cast< std::string >(idx));
+
+	while (true) {
+		if (runTask(idx)) {
+			continue;
+		}
+
+		UniqueLock l(sleepMutex);
+		while (!stopping && queued.get() == 0) {
+			wakeUp.wait(l);
+		}
+
+		if (stopping) {
+			return;
+		}
+	}
+}
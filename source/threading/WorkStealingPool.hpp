@@ -0,0 +1,140 @@
+/**
+ * WorkStealingPool.hpp
+ *
+ *  Created on: 17/ott/2026
+ *      Author: socket
+ */
+
+#ifndef WORKSTEALINGPOOL_HPP_
+#define WORKSTEALINGPOOL_HPP_
+
+#include <deque>
+#include <string>
+#include <utility>
+
+#include <boost/exception_ptr.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/thread.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+
+#include "common/AtomicNumber.hpp"
+
+/**
+ * @class WorkStealingPool
+ *
+ * Fork-join thread pool: every thread owns a deque of tasks, it pushes and
+ * pops new tasks at the back of its own deque and, when it runs out of
+ * them, steals the oldest tasks (the biggest ones, for recursive
+ * algorithms) from the front of other threads deques.
+ *
+ * The thread that submits the first tasks takes part to the computation
+ * while it waits for them, so that a pool of N threads only spawns N-1 new
+ * threads. Only one thread outside the pool should use it at a time.
+ */
+class WorkStealingPool : boost::noncopyable {
+
+public:
+	typedef boost::shared_ptr< WorkStealingPool > Ptr;
+	typedef boost::function< void () > Task;
+
+	/**
+	 * @class TaskGroup
+	 *
+	 * set of tasks that can be waited for all together
+	 */
+	class TaskGroup : boost::noncopyable {
+
+		friend class WorkStealingPool;
+
+	private:
+		// tasks results are published by the release of their decrement
+		AtomicNumber< long, AtomicOrder::ACQ_REL > pending;
+		
+		/** number of tasks that threw: only the first one sets #error */
+		AtomicNumber< long, AtomicOrder::ACQ_REL > failed;
+		boost::exception_ptr error;
+
+	public:
+		TaskGroup() : pending(0), failed(0) { }
+		virtual ~TaskGroup() { }
+	};
+
+private:
+	typedef boost::lock_guard< boost::mutex > LockGuard;
+	typedef boost::unique_lock< boost::mutex > UniqueLock;
+
+	typedef std::pair< Task, TaskGroup * > Entry;
+
+	struct TaskQueue {
+		boost::mutex mutex;
+		std::deque< Entry > tasks;
+	};
+
+private:
+	boost::ptr_vector< TaskQueue > queues;
+	boost::thread_group threads;
+
+	/** index of the queue owned by each pool thread (unset for others) */
+	boost::thread_specific_ptr< unsigned int > queueIdx;
+
+	AtomicNumber< long > queued;
+	boost::mutex sleepMutex;
+	boost::condition_variable wakeUp;
+	volatile bool stopping;
+
+public:
+	/**
+	 * constructor
+	 * @param nThreads number of threads executing tasks, caller included
+	 * @param name name of the pool threads in traces
+	 */
+	WorkStealingPool(unsigned int nThreads, const std::string &name = "pool worker");
+
+	/**
+	 * destructor: waits for pool threads to finish their current task
+	 */
+	virtual ~WorkStealingPool();
+
+	/**
+	 *
+	 * @return number of threads executing tasks, caller included
+	 */
+	unsigned int getThreadsNumber() const;
+
+	/**
+	 * schedules a task
+	 * @param group group the task belongs to
+	 * @param task
+	 */
+	void submit(TaskGroup &group, const Task &task);
+
+	/**
+	 * executes tasks until all the tasks of the group are completed,
+	 * sleeping while the remaining ones are executed by other threads
+	 * @param group
+	 * @throw the exception thrown by the first failed task of the group
+	 */
+	void wait(TaskGroup &group);
+
+	/**
+	 *
+	 * @return index of the calling thread, lower than #getThreadsNumber:
+	 * 0 for threads outside the pool, as they share the caller queue
+	 */
+	unsigned int getThreadIdx() const;
+
+private:
+
+	/**
+	 * runs a task popped from given queue or stolen from the others
+	 * @param idx index of the queue of the calling thread
+	 * @return False if no task was found
+	 */
+	bool runTask(unsigned int idx);
+
+	void workerLoop(unsigned int idx, const std::string &name);
+};
+
+#endif /* WORKSTEALINGPOOL_HPP_ */
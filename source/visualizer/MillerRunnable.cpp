@@ -9,6 +9,7 @@
 
 #include <iostream>
 
+#include "common/Trace.hpp"
 #include "milling/MillingResult.hpp"
 
 MillerRunnable::MillerRunnable(SteppableController::Ptr controller,
@@ -28,6 +29,10 @@ void MillerRunnable::doCycle() throw() {
 	signaler->signalMesher(res.first, res.second);
 }
 
+void MillerRunnable::onBegin() throw() {
+	Trace::nameThread("miller");
+}
+
 void MillerRunnable::onEnd() throw() {
 	signaler->signalMesher();
 }
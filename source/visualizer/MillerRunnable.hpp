@@ -59,6 +59,11 @@ protected:
 	 */
 	virtual void doCycle() throw();
 
+	/**
+	 * executed when miller starts its job
+	 */
+	virtual void onBegin() throw();
+
 	/**
 	 * executed when miller ends its job
 	 */